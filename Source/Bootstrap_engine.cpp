@@ -0,0 +1,211 @@
+#include "Bootstrap_engine.h"
+#include "Trial_summary.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <iomanip>
+#include <random>
+#include <thread>
+#include <system_error>
+#include <stdint.h>
+
+using namespace std;
+
+namespace {
+
+// trial type pairs (a, b) reported as mean(a) - mean(b):
+// retinotopic - spatiotopic, intermediate - spatiotopic, retinotopic - intermediate
+const int contrast_pairs_c[][2] = {{1, 0}, {2, 0}, {1, 2}};
+const int n_contrast_pairs_c = 3;
+
+// resamples per RNG seed; fixed so results do not depend on the thread count
+const int block_size_c = 64;
+
+// joins every started thread when it goes out of scope, so an exception
+// while launching or resampling never destroys a joinable std::thread
+class Thread_joiner {
+public:
+	explicit Thread_joiner(vector<thread>& threads_) : threads(threads_) {}
+	~Thread_joiner()
+		{join();}
+	void join()
+		{
+			for(vector<thread>::size_type t = 0; t < threads.size(); t++)
+				if(threads[t].joinable())
+					threads[t].join();
+		}
+private:
+	vector<thread>& threads;
+};
+
+} // namespace
+
+Bootstrap_engine::Bootstrap_engine(const vector<Trial_record>& records, const vector<long>& bin_starts_,
+	double winsor_fraction) :
+	bin_starts(bin_starts_)
+{
+	if(bin_starts.empty())
+		bin_starts.push_back(0);
+	int n_bins = static_cast<int>(bin_starts.size());
+
+	int n_types = 0;
+	for(vector<Trial_record>::size_type i = 0; i < records.size(); i++)
+		n_types = max(n_types, records[i].trial_type + 1);
+	int n_cells = n_types * n_bins;
+
+	double lo, hi;
+	Trial_summary::winsor_limits(records, winsor_fraction, lo, hi);
+
+	// counting sort of the correct trials into cell order
+	vector<int> cell_of(records.size(), -1);
+	cell_begin.assign(n_cells + 1, 0);
+	for(vector<Trial_record>::size_type i = 0; i < records.size(); i++) {
+		if(!records[i].correct || !records[i].is_analyzed())
+			continue;
+		vector<long>::const_iterator it = upper_bound(bin_starts.begin(), bin_starts.end(), long(records[i].probe_delay));
+		int bin = (it == bin_starts.begin()) ? 0 : static_cast<int>(it - bin_starts.begin()) - 1;
+		cell_of[i] = records[i].trial_type * n_bins + bin;
+		cell_begin[cell_of[i] + 1]++;
+	}
+	for(int c = 0; c < n_cells; c++)
+		cell_begin[c + 1] += cell_begin[c];
+	rt.resize(cell_begin[n_cells]);
+	vector<int> fill(cell_begin.begin(), cell_begin.end() - 1);
+	for(vector<Trial_record>::size_type i = 0; i < records.size(); i++)
+		if(cell_of[i] >= 0)
+			rt[fill[cell_of[i]]++] = static_cast<float>(min(max(double(records[i].rt), lo), hi));
+
+	for(int bin = 0; bin < n_bins; bin++) {
+		for(int p = 0; p < n_contrast_pairs_c; p++) {
+			Contrast c;
+			c.bin = bin;
+			c.type_a = contrast_pairs_c[p][0];
+			c.type_b = contrast_pairs_c[p][1];
+			if(c.type_a >= n_types || c.type_b >= n_types)
+				continue;
+			c.cell_a = c.type_a * n_bins + bin;
+			c.cell_b = c.type_b * n_bins + bin;
+			if(cell_begin[c.cell_a + 1] == cell_begin[c.cell_a] || cell_begin[c.cell_b + 1] == cell_begin[c.cell_b])
+				continue;
+			contrasts.push_back(c);
+		}
+	}
+}
+
+double Bootstrap_engine::cell_mean(int cell) const
+{
+	double total = 0.;
+	for(int i = cell_begin[cell]; i < cell_begin[cell + 1]; i++)
+		total += rt[i];
+	return total / (cell_begin[cell + 1] - cell_begin[cell]);
+}
+
+vector<Bootstrap_interval> Bootstrap_engine::run(int n_resamples, unsigned long seed, int n_threads,
+	double confidence) const
+{
+	vector<Bootstrap_interval> intervals;
+	if(contrasts.empty() || n_resamples <= 0)
+		return intervals;
+
+	// results[r * n_contrasts + c] is contrast c in resample r
+	vector<float> results(static_cast<vector<float>::size_type>(n_resamples) * contrasts.size());
+	int n_blocks = (n_resamples + block_size_c - 1) / block_size_c;
+	if(n_threads <= 0)
+		n_threads = max(1, static_cast<int>(thread::hardware_concurrency()));
+	n_threads = min(n_threads, n_blocks);
+
+	atomic<int> next_block(0);
+	vector<thread> workers;
+	workers.reserve(n_threads - 1);
+	Thread_joiner joiner(workers);
+	try {
+		for(int t = 1; t < n_threads; t++)
+			workers.push_back(thread(&Bootstrap_engine::resample_blocks, this, n_resamples, seed,
+				ref(next_block), ref(results)));
+	}
+	catch(system_error&) {
+		// carry on with the threads we have; the blocks are shared out differently but give the same results
+	}
+	resample_blocks(n_resamples, seed, next_block, results);
+	joiner.join();
+
+	// percentile interval, type 7 quantiles of each contrast's resampled values
+	double alpha = 1. - confidence;
+	vector<float> column(n_resamples);
+	for(vector<Contrast>::size_type c = 0; c < contrasts.size(); c++) {
+		for(int r = 0; r < n_resamples; r++)
+			column[r] = results[r * contrasts.size() + c];
+		sort(column.begin(), column.end());
+		Bootstrap_interval interval;
+		interval.probe_delay = bin_starts[contrasts[c].bin];
+		interval.type_a = contrasts[c].type_a;
+		interval.type_b = contrasts[c].type_b;
+		interval.estimate = cell_mean(contrasts[c].cell_a) - cell_mean(contrasts[c].cell_b);
+		double quantiles[] = {alpha / 2., 1. - alpha / 2.};
+		double bounds[2];
+		for(int q = 0; q < 2; q++) {
+			double h = (n_resamples - 1) * quantiles[q];
+			int lo = static_cast<int>(floor(h));
+			int hi = min(lo + 1, n_resamples - 1);
+			bounds[q] = column[lo] + (h - lo) * (column[hi] - column[lo]);
+		}
+		interval.lower = bounds[0];
+		interval.upper = bounds[1];
+		intervals.push_back(interval);
+	}
+	return intervals;
+}
+
+// worker: take blocks of resamples until none are left
+void Bootstrap_engine::resample_blocks(int n_resamples, unsigned long seed, atomic<int>& next_block,
+	vector<float>& results) const
+{
+	int n_cells = static_cast<int>(cell_begin.size()) - 1;
+	vector<double> means(n_cells);
+	for(;;) {
+		int block = next_block.fetch_add(1, memory_order_relaxed);
+		int first = block * block_size_c;
+		if(first >= n_resamples)
+			return;
+		int last = min(first + block_size_c, n_resamples);
+		seed_seq block_seed = {static_cast<uint32_t>(seed), static_cast<uint32_t>(block)};
+		mt19937 rng(block_seed);
+
+		for(int r = first; r < last; r++) {
+			for(int cell = 0; cell < n_cells; cell++) {
+				uint32_t begin = cell_begin[cell];
+				uint32_t n = cell_begin[cell + 1] - begin;
+				if(n == 0)
+					continue;
+				// stratified draw with replacement; multiply-shift maps a 32-bit draw onto 0 .. n - 1
+				double total = 0.;
+				for(uint32_t i = 0; i < n; i++)
+					total += rt[begin + static_cast<uint32_t>((static_cast<uint64_t>(rng()) * n) >> 32)];
+				means[cell] = total / n;
+			}
+			for(vector<Contrast>::size_type c = 0; c < contrasts.size(); c++)
+				results[r * contrasts.size() + c] = static_cast<float>(means[contrasts[c].cell_a] - means[contrasts[c].cell_b]);
+		}
+	}
+}
+
+string Bootstrap_engine::csv_header()
+{
+	return "PROBE_DELAY,CONTRAST,ESTIMATE,CI_LOWER,CI_UPPER,RESAMPLES";
+}
+
+void Bootstrap_engine::write_csv(ostream& os, const vector<Bootstrap_interval>& intervals,
+	int n_resamples, const string* trial_type_names, const string& prefix)
+{
+	ios::fmtflags flags = os.flags();
+	streamsize precision = os.precision();
+	os << fixed << setprecision(3);
+	for(vector<Bootstrap_interval>::size_type i = 0; i < intervals.size(); i++) {
+		const Bootstrap_interval& b = intervals[i];
+		os << prefix << b.probe_delay << "," << trial_type_names[b.type_a] << "-" << trial_type_names[b.type_b] << ","
+			<< b.estimate << "," << b.lower << "," << b.upper << "," << n_resamples << endl;
+	}
+	os.flags(flags);
+	os.precision(precision);
+}
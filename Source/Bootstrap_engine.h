@@ -0,0 +1,69 @@
+#ifndef BOOTSTRAP_ENGINE_H
+#define BOOTSTRAP_ENGINE_H
+
+#include <vector>
+#include <string>
+#include <iosfwd>
+#include <atomic>
+
+#include "Trial_record.h"
+
+/*
+Bootstrap_engine gives percentile bootstrap confidence intervals for the
+facilitation effects - the difference in mean correct RT between two trial
+types at the same probe delay bin (retinotopic - spatiotopic, intermediate -
+spatiotopic, retinotopic - intermediate).
+
+The constructor copies the RTs of the correct, analyzed trials (see
+Trial_record) into one flat float column grouped by trial type x delay
+cell, so each resample is a stratified draw within contiguous cell ranges. Resamples are split into fixed blocks, each
+with its own RNG seeded from (seed, block); worker threads take blocks from
+a shared counter, so the result depends only on the seed, not on the
+number of threads.
+*/
+
+struct Bootstrap_interval {
+	long probe_delay;	//delay bin start
+	int type_a;			//contrast is mean(type_a) - mean(type_b)
+	int type_b;
+	double estimate;	//observed difference
+	double lower;
+	double upper;
+};
+
+class Bootstrap_engine {
+public:
+	Bootstrap_engine(const std::vector<Trial_record>& records, const std::vector<long>& bin_starts_,
+		double winsor_fraction = 0.);
+
+	// n_threads 0 = one per hardware thread
+	std::vector<Bootstrap_interval> run(int n_resamples, unsigned long seed, int n_threads = 0,
+		double confidence = .95) const;
+
+	int get_n_trials() const
+		{return static_cast<int>(rt.size());}
+
+	// column names written by write_csv after the prefix, without a line end
+	static std::string csv_header();
+	static void write_csv(std::ostream& os, const std::vector<Bootstrap_interval>& intervals,
+		int n_resamples, const std::string* trial_type_names, const std::string& prefix);
+
+private:
+	struct Contrast {
+		int bin;
+		int cell_a;
+		int cell_b;
+		int type_a;
+		int type_b;
+	};
+
+	std::vector<long> bin_starts;
+	std::vector<float> rt;			//correct RTs, grouped by cell
+	std::vector<int> cell_begin;	//cell c spans rt[cell_begin[c]] .. rt[cell_begin[c + 1] - 1]
+	std::vector<Contrast> contrasts;
+
+	double cell_mean(int cell) const;
+	void resample_blocks(int n_resamples, unsigned long seed, std::atomic<int>& next_block, std::vector<float>& results) const;
+};
+
+#endif
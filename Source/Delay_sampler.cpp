@@ -0,0 +1,131 @@
+#include "Delay_sampler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+
+Alias_table::Alias_table(const vector<double>& weights)
+{
+	int n = static_cast<int>(weights.size());
+	double total = 0.;
+	for(int i = 0; i < n; i++) {
+		if(weights[i] < 0.)
+			throw invalid_argument("Alias_table: negative weight");
+		total += weights[i];
+	}
+	if(n == 0 || total <= 0.)
+		throw invalid_argument("Alias_table: weights must have a positive sum");
+
+	prob.assign(n, 0.);
+	alias.assign(n, 0);
+
+	// scale so the average column holds exactly 1
+	vector<double> scaled(n);
+	vector<int> small, large;
+	for(int i = 0; i < n; i++) {
+		scaled[i] = weights[i] * n / total;
+		if(scaled[i] < 1.)
+			small.push_back(i);
+		else
+			large.push_back(i);
+	}
+
+	while(!small.empty() && !large.empty()) {
+		int s = small.back(); small.pop_back();
+		int l = large.back(); large.pop_back();
+		prob[s] = scaled[s];
+		alias[s] = l;
+		scaled[l] = (scaled[l] + scaled[s]) - 1.;
+		if(scaled[l] < 1.)
+			small.push_back(l);
+		else
+			large.push_back(l);
+	}
+	// whatever is left is full up to rounding error
+	for(vector<int>::size_type i = 0; i < large.size(); i++)
+		prob[large[i]] = 1.;
+	for(vector<int>::size_type i = 0; i < small.size(); i++)
+		prob[small[i]] = 1.;
+}
+
+
+Delay_sampler::Delay_sampler()
+{
+	vector<long> delays;
+	delays.push_back(50);
+	delays.push_back(250);
+	delays.push_back(400);
+	set_discrete(delays, vector<double>());
+}
+
+// empty weights means equally likely
+void Delay_sampler::set_discrete(const vector<long>& delays, const vector<double>& weights)
+{
+	if(delays.empty())
+		throw invalid_argument("Delay_sampler: no delays");
+	if(!weights.empty() && weights.size() != delays.size())
+		throw invalid_argument("Delay_sampler: need one weight per delay");
+	table = Alias_table(weights.empty() ? vector<double>(delays.size(), 1.) : weights);
+	values = delays;
+	mode = DISCRETE;
+}
+
+void Delay_sampler::set_uniform(long lo, long hi)
+{
+	if(lo < 0 || hi < lo)
+		throw invalid_argument("Delay_sampler: uniform range must satisfy 0 <= lo <= hi");
+	values.assign(1, lo);
+	values.push_back(hi);
+	table = Alias_table();
+	mode = UNIFORM;
+}
+
+// empty weights means each bin equally likely
+void Delay_sampler::set_histogram(const vector<long>& edges, const vector<double>& weights)
+{
+	if(edges.size() < 2)
+		throw invalid_argument("Delay_sampler: histogram needs at least two edges");
+	for(vector<long>::size_type i = 0; i < edges.size(); i++)
+		if(edges[i] < 0 || (i > 0 && edges[i] <= edges[i - 1]))
+			throw invalid_argument("Delay_sampler: histogram edges must be non-negative and increasing");
+	if(!weights.empty() && weights.size() != edges.size() - 1)
+		throw invalid_argument("Delay_sampler: need one weight per histogram bin");
+	table = Alias_table(weights.empty() ? vector<double>(edges.size() - 1, 1.) : weights);
+	values = edges;
+	mode = HISTOGRAM;
+}
+
+vector<long> Delay_sampler::get_bin_starts(long bin_width) const
+{
+	vector<long> starts;
+	long lo, hi;
+	switch(mode) {
+		case DISCRETE:
+			lo = *min_element(values.begin(), values.end());
+			hi = *max_element(values.begin(), values.end());
+			if(bin_width <= 0) {
+				starts = values;
+				sort(starts.begin(), starts.end());
+				starts.erase(unique(starts.begin(), starts.end()), starts.end());
+				return starts;
+			}
+			break;
+		case UNIFORM:
+			lo = values[0];
+			hi = values[1];
+			if(bin_width <= 0)
+				return vector<long>(1, lo);
+			break;
+		default:
+			lo = values.front();
+			hi = values.back() - 1;
+			if(bin_width <= 0)
+				return vector<long>(values.begin(), values.end() - 1);
+			break;
+	}
+	for(long start = lo - lo % bin_width; start <= hi; start += bin_width)
+		starts.push_back(start);
+	return starts;
+}
@@ -0,0 +1,88 @@
+#ifndef DELAY_SAMPLER_H
+#define DELAY_SAMPLER_H
+
+#include <vector>
+
+#include "Random_draws.h"
+
+/*
+Alias_table draws an index from an arbitrary discrete distribution in O(1)
+using Vose's alias method. A single uniform draw, scaled by the number of
+columns, does both jobs: its integer part picks a column and its fractional
+part decides between the column and its alias. Building the table is O(n).
+*/
+
+class Alias_table {
+public:
+	Alias_table() {}
+	// weights need not be normalized, but must be non-negative with a positive sum
+	explicit Alias_table(const std::vector<double>& weights);
+
+	int size() const
+		{return static_cast<int>(prob.size());}
+
+	template <typename URNG>
+	int sample(URNG& g) const
+		{
+			double u = random_unit(g) * prob.size();
+			int i = static_cast<int>(u);
+			if(i >= size())
+				i = size() - 1;
+			return (u - i < prob[i]) ? i : alias[i];
+		}
+
+private:
+	std::vector<double> prob;
+	std::vector<int> alias;
+};
+
+
+/*
+Delay_sampler supplies post-saccadic probe delays (ms).
+DISCRETE - one of a set of delays, optionally weighted
+UNIFORM - any whole ms in [lo, hi]
+HISTOGRAM - a weighted bin [edges[i], edges[i+1]) chosen by alias table,
+	then a uniform whole ms within it
+get_bin_starts() gives the lower bounds of the statistics cells the
+sampled delays fall into; see Cell_statistics.
+*/
+
+class Delay_sampler {
+public:
+	enum Mode_e {DISCRETE, UNIFORM, HISTOGRAM};
+
+	Delay_sampler();
+
+	void set_discrete(const std::vector<long>& delays, const std::vector<double>& weights);
+	void set_uniform(long lo, long hi);
+	void set_histogram(const std::vector<long>& edges, const std::vector<double>& weights);
+
+	Mode_e get_mode() const
+		{return mode;}
+
+	// statistics cells: bin_width 0 uses the natural cells of the mode
+	// (each delay of the set, or each histogram bin, or one cell for uniform)
+	std::vector<long> get_bin_starts(long bin_width) const;
+
+	template <typename URNG>
+	long sample(URNG& g) const
+		{
+			switch(mode) {
+				case DISCRETE:
+					return values[table.sample(g)];
+				case UNIFORM:
+					return random_between(g, values[0], values[1]);
+				default: {
+					int bin = table.sample(g);
+					return random_between(g, values[bin], values[bin + 1] - 1);
+					}
+			}
+		}
+
+private:
+	Mode_e mode;
+	std::vector<long> values;	//delay set, {lo, hi}, or histogram edges
+	Alias_table table;
+};
+
+#endif
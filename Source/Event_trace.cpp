@@ -0,0 +1,135 @@
+#include "Event_trace.h"
+
+#include <fstream>
+#include <ostream>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+const char magic_c[8] = {'R', 'A', 'T', 'R', 'A', 'C', 'E', '1'};
+
+const char* const kind_names_c[] = {"handle_Start", "handle_Stop", "handle_Delay", "handle_Keystroke",
+	"handle_Eyemovement_End", "state", "trial", "delay", "appear", "property", "disappear", "stop",
+	"saccade_timeout", "exception", "handle_Eyemovement_Start"};
+
+// sizes are fixed so dumps read the same on every platform of the same byte order
+static_assert(sizeof(Trace_event) == 12, "Trace_event must stay 12 bytes");
+
+template <typename T>
+void write_raw(ofstream& out, T x)
+{
+	out.write(reinterpret_cast<const char*>(&x), sizeof(x));
+}
+
+template <typename T>
+bool read_raw(ifstream& in, T& x)
+{
+	return static_cast<bool>(in.read(reinterpret_cast<char*>(&x), sizeof(x)));
+}
+
+void write_labels(ofstream& out, const vector<string>& labels)
+{
+	write_raw(out, static_cast<uint32_t>(labels.size()));
+	for(vector<string>::size_type i = 0; i < labels.size(); i++)
+		out.write(labels[i].c_str(), labels[i].size() + 1);
+}
+
+bool read_labels(ifstream& in, vector<string>& labels)
+{
+	uint32_t n;
+	if(!read_raw(in, n))
+		return false;
+	labels.resize(n);
+	for(uint32_t i = 0; i < n; i++)
+		if(!getline(in, labels[i], '\0'))
+			return false;
+	return true;
+}
+
+const char* label(const vector<string>& labels, int i)
+{
+	return (i >= 0 && i < static_cast<int>(labels.size())) ? labels[i].c_str() : "?";
+}
+
+} // namespace
+
+void Event_trace::set_capacity(int capacity)
+{
+	unsigned long long size = 0;
+	if(capacity > 0)
+		for(size = 1; size < static_cast<unsigned long long>(capacity); size *= 2) {}
+	if(size == events.size())
+		return;
+	events.assign(size, Trace_event());
+	mask = size ? size - 1 : 0;
+	n_recorded = 0;
+}
+
+void Event_trace::set_labels(const char* const* state_labels_, int n_state_labels,
+	const char* const* name_labels_, int n_name_labels)
+{
+	state_labels.assign(state_labels_, state_labels_ + n_state_labels);
+	name_labels.assign(name_labels_, name_labels_ + n_name_labels);
+}
+
+bool Event_trace::dump(const string& filename) const
+{
+	ofstream out(filename.c_str(), ofstream::out | ofstream::trunc | ofstream::binary);
+	if(!out)
+		return false;
+	unsigned long long n = min(n_recorded, static_cast<unsigned long long>(events.size()));
+	out.write(magic_c, sizeof(magic_c));
+	write_raw(out, static_cast<uint32_t>(sizeof(Trace_event)));
+	write_raw(out, static_cast<uint32_t>(n));
+	write_raw(out, static_cast<uint64_t>(n_recorded));
+	write_labels(out, state_labels);
+	write_labels(out, name_labels);
+	// oldest first: the slot after the newest once the buffer has wrapped
+	for(unsigned long long i = n_recorded - n; i < n_recorded; i++)
+		out.write(reinterpret_cast<const char*>(&events[i & mask]), sizeof(Trace_event));
+	return static_cast<bool>(out);
+}
+
+bool Event_trace::print_dump(const string& filename, ostream& os)
+{
+	ifstream in(filename.c_str(), ifstream::binary);
+	char magic[sizeof(magic_c)];
+	uint32_t record_size, n;
+	uint64_t total;
+	vector<string> states, names;
+	if(!in.read(magic, sizeof(magic)) || memcmp(magic, magic_c, sizeof(magic)) != 0
+		|| !read_raw(in, record_size) || record_size != sizeof(Trace_event)
+		|| !read_raw(in, n) || !read_raw(in, total)
+		|| !read_labels(in, states) || !read_labels(in, names))
+		return false;
+
+	os << n << " of " << total << " events" << endl;
+	Trace_event e;
+	for(uint32_t i = 0; i < n; i++) {
+		if(!read_raw(in, e))
+			return false;
+		os << e.time << " " << ((e.kind < n_kinds_c) ? kind_names_c[e.kind] : "?") << " [" << label(states, e.state) << "]";
+		switch(e.kind) {
+			case STATE_CHANGE:
+				os << " from " << label(states, e.value);
+				break;
+			case TRIAL_START:
+			case SCHEDULE_DELAY:
+			case HANDLE_KEYSTROKE:
+			case SACCADE_TIMEOUT:
+				os << " " << e.value;
+				break;
+			default:
+				break;
+		}
+		if(e.object != none_c)
+			os << " " << label(names, e.object);
+		if(e.detail != none_c)
+			os << " " << label(names, e.detail);
+		os << endl;
+	}
+	return true;
+}
@@ -0,0 +1,93 @@
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <vector>
+#include <string>
+#include <iosfwd>
+#include <stdint.h>
+
+/*
+Event_trace is an always-on flight recorder for the device: a fixed-size
+ring buffer of 12-byte binary records, one per handler call, state change,
+scheduled delay and visual object operation. Recording is a single store
+into a preallocated slot, so it can stay enabled in production runs; when
+the buffer is full the oldest events are overwritten.
+
+dump() writes the buffered events, oldest first, to a binary file:
+
+	char[8]   "RATRACE1"
+	uint32    record size (12)
+	uint32    number of records that follow
+	uint64    events recorded in total (the difference was overwritten)
+	uint32    number of state labels, then each label NUL-terminated
+	uint32    number of name labels, then each label NUL-terminated
+	records   Trace_event, in native byte order
+
+The state labels and the object and property name labels are supplied by
+the device, so a dump can be decoded without it; print_dump() writes one
+as text, and the print_trace tool runs it on dump files.
+*/
+
+struct Trace_event {
+	int32_t time;       //simulated time (ms), low 32 bits
+	int32_t value;      //kind-specific: delay length, trial number, previous state, key index
+	uint8_t kind;       //Event_trace::Kind_e
+	uint8_t state;      //device state when the event was recorded
+	uint8_t object;     //name label index of the object, or Event_trace::none_c
+	uint8_t detail;     //name label index of the property for PROPERTY events, or none_c
+};
+
+class Event_trace {
+public:
+	enum Kind_e {HANDLE_START, HANDLE_STOP, HANDLE_DELAY, HANDLE_KEYSTROKE, HANDLE_EYEMOVE_END,
+		STATE_CHANGE, TRIAL_START, SCHEDULE_DELAY, APPEAR, PROPERTY, DISAPPEAR, STOP_RUN,
+		SACCADE_TIMEOUT, EXCEPTION, HANDLE_EYEMOVE_START, n_kinds_c};
+	static const uint8_t none_c = 255;
+
+	Event_trace()
+		: mask(0), n_recorded(0) {}
+
+	// capacity is rounded up to a power of two; 0 turns recording off.
+	// Changing the size clears the buffer.
+	void set_capacity(int capacity);
+	int get_capacity() const
+		{return static_cast<int>(events.size());}
+
+	// labels written to the dump header: state labels index the state field,
+	// name labels the object and detail fields
+	void set_labels(const char* const* state_labels_, int n_state_labels,
+		const char* const* name_labels_, int n_name_labels);
+
+	void record(Kind_e kind, long time, int state, long value = 0, int object = none_c, int detail = none_c)
+		{
+			if(events.empty())
+				return;
+			Trace_event& e = events[n_recorded & mask];
+			e.time = static_cast<int32_t>(time);
+			e.value = static_cast<int32_t>(value);
+			e.kind = static_cast<uint8_t>(kind);
+			e.state = static_cast<uint8_t>(state);
+			e.object = static_cast<uint8_t>(object);
+			e.detail = static_cast<uint8_t>(detail);
+			n_recorded++;
+		}
+
+	void clear()
+		{n_recorded = 0;}
+	unsigned long long get_n_recorded() const
+		{return n_recorded;}
+
+	// returns false if the file could not be written
+	bool dump(const std::string& filename) const;
+	// decode a dump file as one line per event; returns false if it is not a readable dump
+	static bool print_dump(const std::string& filename, std::ostream& os);
+
+private:
+	std::vector<Trace_event> events;
+	unsigned long long mask;		//events.size() - 1
+	unsigned long long n_recorded;	//next slot is n_recorded & mask
+	std::vector<std::string> state_labels;
+	std::vector<std::string> name_labels;
+};
+
+#endif
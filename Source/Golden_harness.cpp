@@ -0,0 +1,133 @@
+#include "Golden_harness.h"
+#include "simple_device.h"
+#include "Synthetic_observer.h"
+#include "EPICLib/Output_tee_globals.h"
+#include "EPICLib/Device_exception.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+string directory_of(const string& filename)
+{
+	string::size_type slash = filename.rfind('/');
+	return (slash == string::npos) ? string() : filename.substr(0, slash + 1);
+}
+
+bool read_file(const string& filename, string& contents)
+{
+	ifstream in(filename.c_str(), ifstream::binary);
+	if(!in)
+		return false;
+	ostringstream oss;
+	oss << in.rdbuf();
+	contents = oss.str();
+	return true;
+}
+
+// describe the first line where the two transcripts differ
+string first_difference(const string& expected, const string& actual)
+{
+	istringstream e(expected), a(actual);
+	string eline, aline;
+	for(int line = 1; ; line++) {
+		bool more_e = static_cast<bool>(getline(e, eline));
+		bool more_a = static_cast<bool>(getline(a, aline));
+		if(!more_e && !more_a)
+			return "transcripts differ only in line endings";
+		if(!more_e || !more_a || eline != aline) {
+			ostringstream oss;
+			oss << "line " << line << "\n    expected: " << (more_e ? eline : string("<end of file>"))
+				<< "\n    actual:   " << (more_a ? aline : string("<end of file>"));
+			return oss.str();
+		}
+	}
+}
+
+} // namespace
+
+string golden_transcript(const string& condition_string, unsigned long seed)
+{
+	ostringstream params;
+	params << condition_string << " seed=" << seed << " debug=0 output=none";
+
+	ostringstream transcript;
+	simple_device device("Simple Device", Normal_out);
+	device.set_parameter_string(params.str());
+	device.attach_recorder(&transcript);
+	Synthetic_observer observer(Observer_profile(), seed);
+	observer.run(device);
+	device.attach_recorder(0);
+	return transcript.str();
+}
+
+int run_golden_suite(const string& manifest_filename, bool record, ostream& report)
+{
+	ifstream manifest(manifest_filename.c_str());
+	if(!manifest) {
+		report << "Cannot open golden manifest: " << manifest_filename << endl;
+		return 1;
+	}
+	string directory = directory_of(manifest_filename);
+
+	int n_cases = 0, n_failures = 0;
+	string line;
+	while(getline(manifest, line)) {
+		string::size_type hash = line.find('#');
+		if(hash != string::npos)
+			line.erase(hash);
+		istringstream iss(line);
+		string golden_name;
+		unsigned long seed;
+		if(!(iss >> golden_name))
+			continue;
+		n_cases++;
+		if(!(iss >> seed)) {
+			report << "FAIL " << golden_name << ": manifest line has no seed" << endl;
+			n_failures++;
+			continue;
+		}
+		string condition_string;
+		getline(iss >> ws, condition_string);
+		string golden_filename = directory + golden_name;
+
+		string actual;
+		try {
+			actual = golden_transcript(condition_string, seed);
+		}
+		catch(Device_exception& x) {
+			report << "FAIL " << golden_name << ": " << x.what() << endl;
+			n_failures++;
+			continue;
+		}
+
+		if(record) {
+			ofstream out(golden_filename.c_str(), ofstream::binary | ofstream::trunc);
+			if(!(out << actual)) {
+				report << "FAIL " << golden_name << ": cannot write " << golden_filename << endl;
+				n_failures++;
+			}
+			else
+				report << "RECORDED " << golden_name << endl;
+			continue;
+		}
+
+		string expected;
+		if(!read_file(golden_filename, expected)) {
+			report << "FAIL " << golden_name << ": no golden file " << golden_filename << " (record it first)" << endl;
+			n_failures++;
+		}
+		else if(expected != actual) {
+			report << "FAIL " << golden_name << ": " << first_difference(expected, actual) << endl;
+			n_failures++;
+		}
+		else
+			report << "ok   " << golden_name << endl;
+	}
+	report << n_cases - n_failures << " of " << n_cases << " golden cases passed" << endl;
+	return n_failures;
+}
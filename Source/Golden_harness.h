@@ -0,0 +1,34 @@
+#ifndef GOLDEN_HARNESS_H
+#define GOLDEN_HARNESS_H
+
+#include <string>
+#include <iosfwd>
+
+/*
+Golden-output regression harness. Each case runs the device under a
+Synthetic_observer with a fixed seed and captures the full transcript of
+simulation calls (appear, property, disappear, delay, stop) and data rows;
+the transcript must match the stored golden file byte for byte, so any
+change to the trial loop that alters behavior is caught.
+
+The manifest has one case per line ('#' comments, blank lines ignored):
+
+	<golden file> <seed> <condition string ...>
+
+Golden file paths are relative to the manifest's directory. The condition
+string is used as given, followed by seed=<seed> debug=0 output=none; the
+observer uses the same seed with the default Observer_profile.
+
+With record set, the transcripts are written as the new golden files
+instead of being compared. Returns the number of failing cases; a summary
+and the first differing line of each failure go to report.
+
+The harness is built into the device_tests tool, not the device library.
+*/
+
+int run_golden_suite(const std::string& manifest_filename, bool record, std::ostream& report);
+
+// run one case and return its transcript
+std::string golden_transcript(const std::string& condition_string, unsigned long seed);
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef RANDOM_DRAWS_H
+#define RANDOM_DRAWS_H
+
+#include <cmath>
+#include <stdint.h>
+
+/*
+Random_draws maps the output of a 32-bit generator (std::mt19937) onto the
+values the device and the observer need. The std:: distributions do the
+same job, but how they consume the generator is left to each standard
+library, so one seed gave different trials under libc++ and libstdc++ and
+golden transcripts could not be shared. These mappings are ours and fully
+specified, so a seed gives the same draws on every platform; the normal
+and exponential draws also go through log and sqrt, whose results are
+rounded to whole ms before anyone sees them.
+*/
+
+// uniform on 0 .. n - 1 for n > 0, without bias (Lemire's multiply-shift with rejection)
+template <typename URNG>
+uint32_t random_below(URNG& g, uint32_t n)
+{
+	uint64_t m = static_cast<uint64_t>(static_cast<uint32_t>(g())) * n;
+	uint32_t low = static_cast<uint32_t>(m);
+	if(low < n) {
+		uint32_t threshold = static_cast<uint32_t>(-n) % n;
+		while(low < threshold) {
+			m = static_cast<uint64_t>(static_cast<uint32_t>(g())) * n;
+			low = static_cast<uint32_t>(m);
+		}
+	}
+	return static_cast<uint32_t>(m >> 32);
+}
+
+// uniform on lo .. hi inclusive; the range must hold fewer than 2^32 values
+template <typename URNG>
+long random_between(URNG& g, long lo, long hi)
+{
+	return lo + static_cast<long>(random_below(g, static_cast<uint32_t>(hi - lo + 1)));
+}
+
+// uniform on [0, 1) with 53 random bits, from two draws
+template <typename URNG>
+double random_unit(URNG& g)
+{
+	uint32_t high = static_cast<uint32_t>(g()) >> 5;
+	uint32_t low = static_cast<uint32_t>(g()) >> 6;
+	return (high * 67108864. + low) * (1. / 9007199254740992.);
+}
+
+// normal by Marsaglia's polar method; the second value of each pair is discarded
+template <typename URNG>
+double random_normal(URNG& g, double mu, double sigma)
+{
+	double x, y, s;
+	do {
+		x = 2. * random_unit(g) - 1.;
+		y = 2. * random_unit(g) - 1.;
+		s = x * x + y * y;
+	} while(s >= 1. || s == 0.);
+	return mu + sigma * x * std::sqrt(-2. * std::log(s) / s);
+}
+
+// exponential with the given mean
+template <typename URNG>
+double random_exponential(URNG& g, double mean)
+{
+	return -mean * std::log(1. - random_unit(g));
+}
+
+#endif
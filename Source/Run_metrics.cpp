@@ -0,0 +1,112 @@
+#include "Run_metrics.h"
+
+#include <fstream>
+#include <cstdio>
+
+using namespace std;
+
+
+void Run_metrics::reset()
+{
+	begin_update();
+	trials_started.store(0, memory_order_relaxed);
+	trials_completed.store(0, memory_order_relaxed);
+	correct.store(0, memory_order_relaxed);
+	incorrect.store(0, memory_order_relaxed);
+	saccade_timeouts.store(0, memory_order_relaxed);
+	events_processed.store(0, memory_order_relaxed);
+	sim_time.store(0, memory_order_relaxed);
+	running.store(false, memory_order_relaxed);
+	end_update();
+}
+
+// single writer, so a plain load/store pair is enough to bump the sequence
+void Run_metrics::begin_update()
+{
+	sequence.store(sequence.load(memory_order_relaxed) + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+void Run_metrics::end_update()
+{
+	sequence.store(sequence.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+void Run_metrics::set_running(bool running_)
+{
+	begin_update();
+	running.store(running_, memory_order_relaxed);
+	end_update();
+}
+
+void Run_metrics::count_event(long now)
+{
+	begin_update();
+	increment(events_processed);
+	sim_time.store(now, memory_order_relaxed);
+	end_update();
+}
+
+void Run_metrics::count_trial_start()
+{
+	begin_update();
+	increment(trials_started);
+	end_update();
+}
+
+void Run_metrics::count_response(bool is_correct)
+{
+	begin_update();
+	increment(trials_completed);
+	increment(is_correct ? correct : incorrect);
+	end_update();
+}
+
+void Run_metrics::count_saccade_timeout()
+{
+	begin_update();
+	increment(saccade_timeouts);
+	end_update();
+}
+
+Metrics_snapshot Run_metrics::snapshot() const
+{
+	Metrics_snapshot s;
+	unsigned long before, after;
+	do {
+		before = sequence.load(memory_order_acquire);
+		s.trials_started = trials_started.load(memory_order_relaxed);
+		s.trials_completed = trials_completed.load(memory_order_relaxed);
+		s.correct = correct.load(memory_order_relaxed);
+		s.incorrect = incorrect.load(memory_order_relaxed);
+		s.saccade_timeouts = saccade_timeouts.load(memory_order_relaxed);
+		s.events_processed = events_processed.load(memory_order_relaxed);
+		s.sim_time = sim_time.load(memory_order_relaxed);
+		s.running = running.load(memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+		after = sequence.load(memory_order_relaxed);
+	} while((before & 1) || before != after);
+	return s;
+}
+
+bool Run_metrics::write_status_file(const string& filename) const
+{
+	Metrics_snapshot s = snapshot();
+	string tmpname = filename + ".tmp";
+	{
+		ofstream out(tmpname.c_str(), ofstream::out | ofstream::trunc);
+		if(!out)
+			return false;
+		out << "running=" << (s.running ? 1 : 0) << endl;
+		out << "trials_started=" << s.trials_started << endl;
+		out << "trials_completed=" << s.trials_completed << endl;
+		out << "correct=" << s.correct << endl;
+		out << "incorrect=" << s.incorrect << endl;
+		out << "saccade_timeouts=" << s.saccade_timeouts << endl;
+		out << "events_processed=" << s.events_processed << endl;
+		out << "sim_time=" << s.sim_time << endl;
+		if(!out)
+			return false;
+	}
+	return rename(tmpname.c_str(), filename.c_str()) == 0;
+}
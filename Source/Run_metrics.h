@@ -0,0 +1,66 @@
+#ifndef RUN_METRICS_H
+#define RUN_METRICS_H
+
+#include <atomic>
+#include <string>
+
+/*
+Run_metrics holds live progress counters for one device run. The device
+thread is the only writer; any other thread (a monitor, a sweep driver)
+may call snapshot() at any time. Counters are relaxed atomics grouped under
+a sequence lock, so updates cost a few uncontended stores and a snapshot
+never mixes values from two different updates.
+*/
+
+struct Metrics_snapshot {
+	long trials_started;
+	long trials_completed;     //trials with a response
+	long correct;
+	long incorrect;
+	long saccade_timeouts;     //trials abandoned waiting for the eye movement
+	long events_processed;     //handler calls of any kind
+	long sim_time;             //simulated time of the latest event (ms)
+	bool running;
+};
+
+class Run_metrics {
+public:
+	Run_metrics() :
+		sequence(0)
+		{
+			reset();
+		}
+	// writer side - call only from the device thread; reset() is an update like
+	// any other, so a concurrent snapshot sees either the old run or the zeroes
+	void reset();
+	void set_running(bool running_);
+	void count_event(long now);
+	void count_trial_start();
+	void count_response(bool is_correct);
+	void count_saccade_timeout();
+
+	// reader side - safe from any thread
+	Metrics_snapshot snapshot() const;
+
+	// write a snapshot as key=value lines to filename, replacing it atomically
+	// (written to filename.tmp, then renamed); returns false on failure
+	bool write_status_file(const std::string& filename) const;
+
+private:
+	std::atomic<unsigned long> sequence;	//odd while an update is in progress
+	std::atomic<long> trials_started;
+	std::atomic<long> trials_completed;
+	std::atomic<long> correct;
+	std::atomic<long> incorrect;
+	std::atomic<long> saccade_timeouts;
+	std::atomic<long> events_processed;
+	std::atomic<long> sim_time;
+	std::atomic<bool> running;
+
+	void begin_update();
+	void end_update();
+	void increment(std::atomic<long>& counter)
+		{counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);}
+};
+
+#endif
@@ -0,0 +1,253 @@
+#include "Shard_merge.h"
+
+#include <iostream>
+#include <sstream>
+#include <queue>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+// field i of a csv line, or an empty string if there are fewer fields
+string csv_field(const string& line, int i)
+{
+	string::size_type begin = 0;
+	for(int field = 0; field < i; field++) {
+		begin = line.find(',', begin);
+		if(begin == string::npos)
+			return string();
+		begin++;
+	}
+	return line.substr(begin, line.find(',', begin) - begin);
+}
+
+int column_index(const string& header, const string& name)
+{
+	istringstream iss(header);
+	string field;
+	for(int i = 0; getline(iss, field, ','); i++)
+		if(field == name)
+			return i;
+	return -1;
+}
+
+bool parse_long(const string& s, long& x)
+{
+	if(s.empty())
+		return false;
+	char* end;
+	x = strtol(s.c_str(), &end, 10);
+	return *end == '\0';
+}
+
+class Shard_reader {
+public:
+	Shard_reader(istream& in_, const string& filename_) :
+		filename(filename_), in(in_), line_number(0), run_id(0), trial(0),
+		run_column(-1), trial_column(-1) {}
+
+	// the first non-blank line; false if there is none
+	bool read_header(string& header)
+		{
+			while(getline(in, header)) {
+				line_number++;
+				if(!header.empty() && header != "\r")
+					return true;
+			}
+			return false;
+		}
+
+	void set_columns(int run_column_, int trial_column_)
+		{
+			run_column = run_column_;
+			trial_column = trial_column_;
+		}
+
+	// advance to the next row; false at the end of the file or on a malformed row (see error)
+	bool next()
+		{
+			while(getline(in, line)) {
+				line_number++;
+				if(line.empty() || line == "\r")
+					continue;
+				long previous_trial = trial;
+				if(!parse_long(csv_field(line, run_column), run_id)) {
+					error = "bad RUN_ID";
+					break;
+				}
+				if(trial_column >= 0 && !parse_long(csv_field(line, trial_column), trial)) {
+					error = "bad TRIAL";
+					break;
+				}
+				if(trial_column < 0)
+					trial = previous_trial + 1;
+				return true;
+			}
+			return false;
+		}
+
+	string filename;
+	istream& in;
+	string line;
+	string error;		//set when next() stopped at a malformed row
+	long line_number;
+	long run_id;		//of the current line
+	long trial;			//of the current line; a running count if there is no TRIAL column
+
+private:
+	int run_column;
+	int trial_column;
+};
+
+void report_missing(ostream& log, long first, long last)
+{
+	if(first == last)
+		log << "missing run " << first << endl;
+	else
+		log << "missing runs " << first << " to " << last << endl;
+}
+
+// heap entry: the shard whose current line has the smallest run id comes first
+struct Next_run {
+	long run_id;
+	int shard;
+	bool operator< (const Next_run& rhs) const
+		{return (run_id != rhs.run_id) ? run_id > rhs.run_id : shard > rhs.shard;}
+};
+
+} // namespace
+
+int merge_shards(const vector<istream*>& shard_streams, const vector<string>& shard_names,
+	ostream& merged, ostream& log, long first_run, long expected_runs)
+{
+	// read every header and check that they agree
+	vector<Shard_reader> shards;
+	shards.reserve(shard_streams.size());
+	string header;
+	int status = 0;
+	for(vector<istream*>::size_type i = 0; i < shard_streams.size(); i++) {
+		shards.push_back(Shard_reader(*shard_streams[i], shard_names[i]));
+		Shard_reader& shard = shards.back();
+		string shard_header;
+		if(!shard.in || !shard.read_header(shard_header)) {
+			log << shard.filename << ": cannot read header" << endl;
+			status = 2;
+		}
+		else if(header.empty())
+			header = shard_header;
+		else if(shard_header != header) {
+			log << shard.filename << ": header differs from " << shards[0].filename << endl;
+			status = 2;
+		}
+	}
+	int run_column = column_index(header, "RUN_ID");
+	if(status == 0 && run_column < 0) {
+		log << shards[0].filename << ": no RUN_ID column - not sharded output" << endl;
+		status = 2;
+	}
+	if(status == 2)
+		return status;
+	merged << header << endl;
+
+	// a worker whose shard has no rows at all lost its runs, even if no gap shows
+	int trial_column = column_index(header, "TRIAL");
+	priority_queue<Next_run> heap;
+	long n_empty = 0;
+	for(vector<Shard_reader>::size_type i = 0; i < shards.size(); i++) {
+		shards[i].set_columns(run_column, trial_column);
+		if(shards[i].next()) {
+			Next_run n = {shards[i].run_id, static_cast<int>(i)};
+			heap.push(n);
+		}
+		else if(!shards[i].error.empty()) {
+			log << shards[i].filename << ":" << shards[i].line_number << ": " << shards[i].error << endl;
+			status = 2;
+		}
+		else {
+			log << shards[i].filename << ": no rows - its runs are missing" << endl;
+			n_empty++;
+		}
+	}
+
+	// copy one run from one shard per step; run ids leave the heap in order, so a
+	// repeat of the last run is a duplicate and a jump past the next id leaves a gap
+	long last_run = first_run - 1;
+	long n_runs = 0, n_rows = 0, n_missing = 0;
+	long n_duplicates = 0;	//run copies dropped: repeats, and runs before first_run
+	while(status == 0 && !heap.empty()) {
+		Next_run n = heap.top();
+		heap.pop();
+		Shard_reader& shard = shards[n.shard];
+		bool duplicate = n.run_id <= last_run;
+		if(n.run_id < first_run) {
+			log << shard.filename << ":" << shard.line_number << ": run " << n.run_id
+				<< " is before the first run " << first_run << ", dropped" << endl;
+			n_duplicates++;
+		}
+		else if(duplicate) {
+			log << shard.filename << ":" << shard.line_number << ": run " << n.run_id << " duplicated, dropped" << endl;
+			n_duplicates++;
+		}
+		else {
+			if(n.run_id > last_run + 1) {
+				report_missing(log, last_run + 1, n.run_id - 1);
+				n_missing += n.run_id - last_run - 1;
+			}
+			last_run = n.run_id;
+			n_runs++;
+		}
+
+		// the run's rows are contiguous; a second copy appended to the same shard shows as its TRIAL restarting
+		long previous_trial = shard.trial - 1;
+		bool more = true;
+		while(more && shard.run_id == n.run_id) {
+			if(shard.trial <= previous_trial) {
+				log << shard.filename << ":" << shard.line_number << ": run " << n.run_id
+					<< " repeated within the shard, dropped" << endl;
+				duplicate = true;
+				n_duplicates++;
+				previous_trial = shard.trial;
+				// skip the rest of the repeated copy
+				while((more = shard.next()) && shard.run_id == n.run_id) {}
+				break;
+			}
+			previous_trial = shard.trial;
+			if(!duplicate) {
+				merged << shard.line << '\n';
+				n_rows++;
+			}
+			more = shard.next();
+		}
+		if(more) {
+			// runs starting over mean a rerun appended another pass to the shard; its
+			// next run is at or below the last one merged, so it comes off the heap
+			// next and is dropped, and so are the others until the pass gets past it
+			if(shard.run_id < n.run_id)
+				log << shard.filename << ":" << shard.line_number << ": run " << shard.run_id
+					<< " follows run " << n.run_id << " - a rerun appended to the shard" << endl;
+			Next_run next = {shard.run_id, n.shard};
+			heap.push(next);
+		}
+		else if(!shard.error.empty()) {
+			log << shard.filename << ":" << shard.line_number << ": " << shard.error << endl;
+			status = 2;
+		}
+	}
+
+	if(status == 0 && expected_runs > 0 && last_run < first_run + expected_runs - 1) {
+		report_missing(log, last_run + 1, first_run + expected_runs - 1);
+		n_missing += first_run + expected_runs - 1 - last_run;
+	}
+
+	log << shards.size() << " shards, " << n_runs << " runs, " << n_rows << " rows merged";
+	if(n_missing || n_duplicates || n_empty)
+		log << "; " << n_missing << " runs missing, " << n_duplicates << " copies dropped, "
+			<< n_empty << " empty shards";
+	if(status == 2)
+		log << "; merge abandoned";
+	log << endl;
+	if(status == 0 && (n_missing || n_duplicates || n_empty))
+		status = 1;
+	return status;
+}
@@ -0,0 +1,37 @@
+#ifndef SHARD_MERGE_H
+#define SHARD_MERGE_H
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+/*
+merge_shards combines the per-worker output shards of a sweep into one
+stream. Devices run with shard=<worker> write data_output_shard<worker>.csv
+(and likewise the summary, bootstrap and timing files); every row starts
+with SHARD and RUN_ID, and each run's rows are contiguous.
+
+The merge is a k-way merge on RUN_ID, holding one line per shard in memory;
+the rows go to merged under the shards' common header. Every shard must
+have the same header with a RUN_ID column. Run ids must run without gaps
+from first_run up to the last one seen, or through expected_runs runs if
+that is positive, and a shard with no rows at all is reported as missing
+its runs. A run found in more than one shard, or repeated within a shard,
+is a duplicate: the first copy is kept and the others dropped.
+
+A shard's runs are in increasing RUN_ID order, except that a worker rerun
+appends another pass to its existing shard; a run id lower than the one
+before it starts such a repeated copy, whose runs are dropped as duplicates
+unless they were never merged. A run repeated back to back shows as its
+TRIAL numbers starting over, for files that have a TRIAL column.
+
+Problems are reported on log, one line each, followed by a one-line
+summary. Returns 0 if the shards were complete and consistent, 1 if runs
+were missing or duplicated (merged still has every run found), 2 if the
+shards could not be read or do not match (merged must be discarded).
+*/
+
+int merge_shards(const std::vector<std::istream*>& shards, const std::vector<std::string>& shard_names,
+	std::ostream& merged, std::ostream& log, long first_run = 1, long expected_runs = 0);
+
+#endif
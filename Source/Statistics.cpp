@@ -1,6 +1,7 @@
 #include "Statistics.h"
 
 #include <cmath>
+#include <algorithm>
 
 using namespace std;
 
@@ -13,4 +14,34 @@ double Current_rms_error::update(GU::Point p1, GU::Point p2)
 	rms = sqrt(total / n);
 	return rms;
 }
-		
+
+
+double Current_variance::get_sd() const
+{
+	return sqrt(get_var());
+}
+
+double Current_variance::get_se() const
+{
+	return (n > 0) ? get_sd() / sqrt(double(n)) : 0.;
+}
+
+
+void Cell_statistics::configure(int n_rows_, const vector<long>& bin_starts_)
+{
+	n_rows = n_rows_;
+	bin_starts = bin_starts_;
+	cells.assign(n_rows * bin_starts.size(), Current_variance());
+}
+
+void Cell_statistics::reset()
+{
+	for(vector<Current_variance>::size_type i = 0; i < cells.size(); i++)
+		cells[i].reset();
+}
+
+int Cell_statistics::get_bin(long delay) const
+{
+	vector<long>::const_iterator it = upper_bound(bin_starts.begin(), bin_starts.end(), delay);
+	return (it == bin_starts.begin()) ? 0 : static_cast<int>(it - bin_starts.begin()) - 1;
+}
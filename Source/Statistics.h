@@ -2,6 +2,7 @@
 #define STATISTICS_H
 
 #include <EPICLib/Geometry.h>
+#include <vector>
 namespace GU = Geometry_Utilities;
 
 
@@ -72,6 +73,81 @@ private:
 };
 
 
+/*
+Current_variance also tracks the spread (Welford's update), so a standard
+deviation and standard error are available without keeping the data.
+*/
+
+class Current_variance{
+public:
+	Current_variance()
+		{
+			reset();
+		}
+	void reset()
+		{
+			n = 0;
+			mean = 0.;
+			m2 = 0.;
+		}
+	
+	int get_n() const
+		{return n;}
+	double get_mean() const
+		{return mean;}
+	double get_var() const
+		{return (n > 1) ? m2 / (n - 1) : 0.;}
+	double get_sd() const;
+	double get_se() const;
+			
+	double update(double x)
+		{
+			n++;
+			double delta = x - mean;
+			mean += delta / n;
+			m2 += delta * (x - mean);
+			return mean;
+		}
+			
+private:
+	int n;
+	double mean;
+	double m2;
+};
+
+
+/*
+Cell_statistics keeps a Current_variance per (row, delay bin) cell, where
+rows are trial types and bins are given by their lower bounds. A delay
+falls in the last bin whose start is <= the delay; delays below the
+first start go in the first bin.
+*/
+
+class Cell_statistics {
+public:
+	Cell_statistics() : n_rows(0)
+		{}
+	void configure(int n_rows_, const std::vector<long>& bin_starts_);
+	void reset();
+	
+	void update(int row, long delay, double x)
+		{cells[row * bin_starts.size() + get_bin(delay)].update(x);}
+	
+	int get_n_rows() const
+		{return n_rows;}
+	int get_n_bins() const
+		{return static_cast<int>(bin_starts.size());}
+	long get_bin_start(int bin) const
+		{return bin_starts[bin];}
+	int get_bin(long delay) const;
+	const Current_variance& get_cell(int row, int bin) const
+		{return cells[row * bin_starts.size() + bin];}
+	
+private:
+	int n_rows;
+	std::vector<long> bin_starts;
+	std::vector<Current_variance> cells;
+};
 
 
 #endif
@@ -0,0 +1,137 @@
+#include "Synthetic_observer.h"
+#include "simple_device.h"
+#include "Random_draws.h"
+#include "EPICLib/Device_exception.h"
+
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+// attaches the observer for its lifetime, so the device is detached on every
+// way out of run(), including an exception thrown by one of its handlers
+class Observer_attachment {
+public:
+	Observer_attachment(simple_device& device_, Synthetic_observer* observer) : device(device_)
+		{device.attach_observer(observer);}
+	~Observer_attachment()
+		{device.attach_observer(0);}
+private:
+	simple_device& device;
+};
+
+} // namespace
+
+Observer_profile::Observer_profile() :
+	rt_mu(380.), rt_sigma(40.), rt_tau(60.), rt_min(150.), error_rate(0.05),
+	latency_mu(180.), latency_sigma(25.), latency_tau(40.), movement_time(45.), miss_rate(0.)
+{
+	// spatiotopic, retinotopic, intermediate
+	facilitation_amplitude[0] = 30.;
+	facilitation_amplitude[1] = 40.;
+	facilitation_amplitude[2] = 15.;
+	facilitation_decay[0] = 0.;
+	facilitation_decay[1] = 150.;
+	facilitation_decay[2] = 150.;
+}
+
+double Observer_profile::facilitation(int trial_type_index, long probe_delay) const
+{
+	double amplitude = facilitation_amplitude[trial_type_index];
+	double decay = facilitation_decay[trial_type_index];
+	return (decay > 0.) ? amplitude * exp(-probe_delay / decay) : amplitude;
+}
+
+
+Synthetic_observer::Synthetic_observer(const Observer_profile& profile_, unsigned long seed) :
+	profile(profile_), rng(static_cast<mt19937::result_type>(seed)),
+	time(0), next_sequence(0), events_dispatched(0), stopped(false)
+{
+}
+
+void Synthetic_observer::run(simple_device& device)
+{
+	events = priority_queue<Event>();
+	time = 0;
+	next_sequence = 0;
+	events_dispatched = 0;
+	stopped = false;
+
+	Observer_attachment attachment(device, this);
+	device.handle_Start_event();
+	while(!stopped && !events.empty()) {
+		Event event = events.top();
+		events.pop();
+		time = event.time;
+		events_dispatched++;
+		switch(event.type) {
+			case DELAY:
+				device.handle_Delay_event(Symbol(), Symbol(), Symbol(), Symbol(), Symbol());
+				break;
+			case EYEMOVEMENT_START:
+				device.handle_Eyemovement_Start_event(Symbol(), event.location);
+				break;
+			case EYEMOVEMENT_END:
+				device.handle_Eyemovement_End_event(Symbol(), event.location);
+				break;
+			case KEYSTROKE:
+				device.handle_Keystroke_event(event.key);
+				break;
+		}
+	}
+	// nothing left to deliver, yet the device is still waiting - e.g. for a missed
+	// saccade with no saccade_timeout; a Stop would hide the hang, so report it
+	if(!stopped)
+		throw Device_exception(&device, "Synthetic_observer: no events pending but the device has not stopped");
+	device.handle_Stop_event();
+}
+
+void Synthetic_observer::schedule_delay(long delay)
+{
+	post(delay, DELAY);
+}
+
+void Synthetic_observer::saccade_target_presented(GU::Point location)
+{
+	long latency = lround(ex_gaussian(profile.latency_mu, profile.latency_sigma, profile.latency_tau));
+	if(latency < 0)
+		latency = 0;
+	// a miss lands on the far side of the screen, never on a stimulus location
+	GU::Point landing = chance(profile.miss_rate) ? GU::Point(-location.x * 3 - 1, -location.y * 3 - 1) : location;
+	post(latency, EYEMOVEMENT_START, landing);
+	post(latency + lround(profile.movement_time), EYEMOVEMENT_END, landing);
+}
+
+void Synthetic_observer::probe_presented(int trial_type_index, long probe_delay, const Symbol& correct_key, const Symbol& wrong_key)
+{
+	double rt = ex_gaussian(profile.rt_mu, profile.rt_sigma, profile.rt_tau)
+		- profile.facilitation(trial_type_index, probe_delay);
+	if(rt < profile.rt_min)
+		rt = profile.rt_min;
+	post(lround(rt), KEYSTROKE, GU::Point(), chance(profile.error_rate) ? wrong_key : correct_key);
+}
+
+void Synthetic_observer::post(long delay, Event_e type, GU::Point location, const Symbol& key)
+{
+	Event event;
+	event.time = time + delay;
+	event.sequence = next_sequence++;
+	event.type = type;
+	event.location = location;
+	event.key = key;
+	events.push(event);
+}
+
+double Synthetic_observer::ex_gaussian(double mu, double sigma, double tau)
+{
+	double x = (sigma > 0.) ? random_normal(rng, mu, sigma) : mu;
+	if(tau > 0.)
+		x += random_exponential(rng, tau);
+	return x;
+}
+
+bool Synthetic_observer::chance(double p)
+{
+	return p > 0. && random_unit(rng) < p;
+}
@@ -0,0 +1,97 @@
+#ifndef SYNTHETIC_OBSERVER_H
+#define SYNTHETIC_OBSERVER_H
+
+#include <vector>
+#include <queue>
+#include <random>
+
+#include "EPICLib/Symbol.h"
+#include "EPICLib/Geometry.h"
+
+namespace GU = Geometry_Utilities;
+
+class simple_device;
+
+/*
+Synthetic_observer stands in for the EPIC architecture so the device can be
+run on its own: it keeps the simulated clock and event queue, receives the
+device's display calls, and answers with eye movements and keystrokes drawn
+from configurable distributions. Typical use:
+
+	simple_device device("Simple Device", Normal_out);
+	device.set_parameter_string("n_trials=100000 debug=0 seed=1");
+	Synthetic_observer observer(Observer_profile(), 1);
+	observer.run(device);
+
+Keystroke RT is ex-Gaussian (normal mu, sigma plus exponential tau) minus
+an attentional facilitation of amplitude * exp(-probe_delay / decay) for
+the probe's trial type, so the analysis can be checked against a known
+ground-truth effect. Saccade latency is ex-Gaussian as well.
+*/
+
+struct Observer_profile {
+	// keystroke RT after probe onset (ms)
+	double rt_mu, rt_sigma, rt_tau;
+	double rt_min;                          //floor after facilitation
+	double error_rate;                      //chance of pressing the wrong key
+	// facilitation by trial type (spatiotopic, retinotopic, intermediate)
+	double facilitation_amplitude[3];       //ms subtracted at probe delay 0
+	double facilitation_decay[3];           //ms time constant; 0 = constant
+	// saccade to the target
+	double latency_mu, latency_sigma, latency_tau;
+	double movement_time;                   //eye movement start to end (ms)
+	double miss_rate;                       //chance the saccade lands off target
+
+	Observer_profile();
+	// expected RT reduction for a trial type at a probe delay
+	double facilitation(int trial_type_index, long probe_delay) const;
+};
+
+class Synthetic_observer {
+public:
+	Synthetic_observer(const Observer_profile& profile_, unsigned long seed);
+
+	// run the device from its Start event until it stops itself, then
+	// deliver the Stop event; the device is attached only for the duration.
+	// Throws Device_exception if the device stalls: the event queue is empty
+	// but it has not stopped (no Stop is delivered then).
+	void run(simple_device& device);
+
+	// calls from the attached device
+	long get_time() const
+		{return time;}
+	void schedule_delay(long delay);
+	void stop()
+		{stopped = true;}
+	void saccade_target_presented(GU::Point location);
+	void probe_presented(int trial_type_index, long probe_delay, const Symbol& correct_key, const Symbol& wrong_key);
+
+	long get_events_dispatched() const
+		{return events_dispatched;}
+
+private:
+	enum Event_e {DELAY, EYEMOVEMENT_START, EYEMOVEMENT_END, KEYSTROKE};
+	struct Event {
+		long time;
+		long sequence;	//keeps events due at the same time in scheduling order
+		Event_e type;
+		GU::Point location;
+		Symbol key;
+		bool operator< (const Event& rhs) const	//reversed for a min-heap
+			{return (time != rhs.time) ? time > rhs.time : sequence > rhs.sequence;}
+	};
+
+	Observer_profile profile;
+	std::mt19937 rng;
+	std::priority_queue<Event> events;
+	long time;
+	long next_sequence;
+	long events_dispatched;
+	bool stopped;
+
+	void post(long delay, Event_e type, GU::Point location = GU::Point(), const Symbol& key = Symbol());
+	double ex_gaussian(double mu, double sigma, double tau);
+	bool chance(double p);
+};
+
+#endif
@@ -0,0 +1,390 @@
+#include "Task_parameters.h"
+#include "Delay_sampler.h"
+
+#include <sstream>
+#include <fstream>
+#include <cctype>
+
+using namespace std;
+
+namespace {
+
+// read a whole value of type T, rejecting trailing junk
+template <typename T>
+T convert(const string& key, const string& value)
+{
+	istringstream iss(value);
+	T result;
+	iss >> result;
+	if(!iss || !(iss >> ws).eof())
+		throw Parameter_error("Bad value for " + key + ": \"" + value + "\"");
+	return result;
+}
+
+bool convert_bool(const string& key, const string& value)
+{
+	if(value == "1" || value == "true" || value == "yes" || value == "on")
+		return true;
+	if(value == "0" || value == "false" || value == "no" || value == "off")
+		return false;
+	throw Parameter_error("Bad value for " + key + " (expected 0 or 1): \"" + value + "\"");
+}
+
+template <typename T>
+vector<T> convert_list(const string& key, const string& value)
+{
+	vector<T> result;
+	istringstream iss(value);
+	string item;
+	while(getline(iss, item, ','))
+		result.push_back(convert<T>(key, item));
+	return result;
+}
+
+// split on whitespace and ';'
+vector<string> tokenize(const string& s)
+{
+	vector<string> tokens;
+	string token;
+	for(string::size_type i = 0; i < s.size(); i++) {
+		char c = s[i];
+		if(isspace(static_cast<unsigned char>(c)) || c == ';') {
+			if(!token.empty())
+				tokens.push_back(token);
+			token.clear();
+		}
+		else
+			token += c;
+	}
+	if(!token.empty())
+		tokens.push_back(token);
+	return tokens;
+}
+
+} // namespace
+
+Task_parameters::Task_parameters() :
+	n_trials(10), locus_eccentricity(8.3 / 2), cue_proximity(2.5), tag("Draft"),
+	probe_delay_mode(DELAY_DISCRETE), probe_delay_bin(0), saccade(true), probe_distractors(false),
+	start_delay(500), fixation_duration(500), cue_duration(200), post_cue_duration(500),
+	probe_linger(500), intertrial_interval(5000), shutdown_delay(500), saccade_timeout(0),
+	spatiotopic_weight(1.), retinotopic_weight(1.), intermediate_weight(1.),
+	seed(0), output_mode(OUTPUT_CSV), output_file("data_output"),
+	summary(true), summary_file("summary_output"), winsor(0.), timing(true), timing_file("timing_output"),
+	bootstrap(0), bootstrap_threads(0), bootstrap_file("bootstrap_output"), show_debug(true),
+	status_interval(0), trace_size(4096), trace_file("trace_dump"),
+	shard(-1), run_id(0)
+{
+	probe_delays.push_back(50);
+	probe_delays.push_back(250);
+	probe_delays.push_back(400);
+}
+
+void Task_parameters::parse(const string& condition_string)
+{
+	parse(condition_string, Task_parameters());
+}
+
+void Task_parameters::parse(const string& condition_string, const Task_parameters& base)
+{
+	// work on a copy of the base; a bad string leaves the current settings intact
+	Task_parameters p(base);
+	vector<string> tokens = tokenize(condition_string);
+	vector<string>::size_type i = 0;
+
+	// legacy positional prefix: trials locus_width cue_proximity [tag]
+	if(!tokens.empty() && tokens[0].find('=') == string::npos) {
+		if(tokens.size() < 3 || tokens[1].find('=') != string::npos || tokens[2].find('=') != string::npos)
+			throw Parameter_error("Positional form needs: trials locus_width cue_proximity [tag]");
+		p.set("n_trials", tokens[0]);
+		p.set("locus_width", tokens[1]);
+		p.set("cue_proximity", tokens[2]);
+		i = 3;
+		if(i < tokens.size() && tokens[i].find('=') == string::npos)
+			p.set("tag", tokens[i++]);
+	}
+
+	for(; i < tokens.size(); i++) {
+		string::size_type eq = tokens[i].find('=');
+		if(eq == string::npos || eq == 0)
+			throw Parameter_error("Expected key=value, got \"" + tokens[i] + "\"");
+		p.set(tokens[i].substr(0, eq), tokens[i].substr(eq + 1));
+	}
+
+	p.validate();
+	*this = p;
+}
+
+void Task_parameters::set(const string& key, const string& value)
+{
+	if(key == "n_trials" || key == "trials")
+		n_trials = convert<int>(key, value);
+	else if(key == "locus_eccentricity")
+		locus_eccentricity = convert<double>(key, value);
+	else if(key == "locus_width")
+		locus_eccentricity = convert<double>(key, value) / 2;
+	else if(key == "cue_proximity")
+		cue_proximity = convert<double>(key, value);
+	else if(key == "tag")
+		tag = value;
+	else if(key == "probe_delays")
+		probe_delays = convert_list<long>(key, value);
+	else if(key == "probe_delay_mode") {
+		if(value == "discrete")
+			probe_delay_mode = DELAY_DISCRETE;
+		else if(value == "uniform")
+			probe_delay_mode = DELAY_UNIFORM;
+		else if(value == "histogram")
+			probe_delay_mode = DELAY_HISTOGRAM;
+		else
+			throw Parameter_error("probe_delay_mode must be discrete, uniform or histogram: \"" + value + "\"");
+	}
+	else if(key == "probe_delay_range")
+		probe_delay_range = convert_list<long>(key, value);
+	else if(key == "probe_delay_edges")
+		probe_delay_edges = convert_list<long>(key, value);
+	else if(key == "probe_delay_weights")
+		probe_delay_weights = convert_list<double>(key, value);
+	else if(key == "probe_delay_bin")
+		probe_delay_bin = convert<long>(key, value);
+	else if(key == "saccade")
+		saccade = convert_bool(key, value);
+	else if(key == "probe_distractors")
+		probe_distractors = convert_bool(key, value);
+	else if(key == "start_delay")
+		start_delay = convert<long>(key, value);
+	else if(key == "fixation_duration")
+		fixation_duration = convert<long>(key, value);
+	else if(key == "cue_duration")
+		cue_duration = convert<long>(key, value);
+	else if(key == "post_cue_duration")
+		post_cue_duration = convert<long>(key, value);
+	else if(key == "probe_linger")
+		probe_linger = convert<long>(key, value);
+	else if(key == "intertrial_interval" || key == "iti")
+		intertrial_interval = convert<long>(key, value);
+	else if(key == "shutdown_delay")
+		shutdown_delay = convert<long>(key, value);
+	else if(key == "saccade_timeout")
+		saccade_timeout = convert<long>(key, value);
+	else if(key == "spatiotopic_weight")
+		spatiotopic_weight = convert<double>(key, value);
+	else if(key == "retinotopic_weight")
+		retinotopic_weight = convert<double>(key, value);
+	else if(key == "intermediate_weight")
+		intermediate_weight = convert<double>(key, value);
+	else if(key == "seed")
+		seed = convert<unsigned long>(key, value);
+	else if(key == "output") {
+		if(value == "csv")
+			output_mode = OUTPUT_CSV;
+		else if(value == "none")
+			output_mode = OUTPUT_NONE;
+		else
+			throw Parameter_error("output must be csv or none: \"" + value + "\"");
+	}
+	else if(key == "output_file")
+		output_file = value;
+	else if(key == "summary")
+		summary = convert_bool(key, value);
+	else if(key == "summary_file")
+		summary_file = value;
+	else if(key == "winsor")
+		winsor = convert<double>(key, value);
+	else if(key == "timing")
+		timing = convert_bool(key, value);
+	else if(key == "timing_file")
+		timing_file = value;
+	else if(key == "bootstrap")
+		bootstrap = convert<int>(key, value);
+	else if(key == "bootstrap_threads")
+		bootstrap_threads = convert<int>(key, value);
+	else if(key == "bootstrap_file")
+		bootstrap_file = value;
+	else if(key == "debug")
+		show_debug = convert_bool(key, value);
+	else if(key == "status_file")
+		status_file = value;
+	else if(key == "status_interval")
+		status_interval = convert<int>(key, value);
+	else if(key == "trace_size")
+		trace_size = convert<int>(key, value);
+	else if(key == "trace_file")
+		trace_file = value;
+	else if(key == "shard")
+		shard = convert<int>(key, value);
+	else if(key == "run_id")
+		run_id = convert<long>(key, value);
+	else if(key == "config")
+		read_file(value);
+	else
+		throw Parameter_error("Unknown parameter: " + key);
+}
+
+void Task_parameters::read_file(const string& filename)
+{
+	ifstream in(filename.c_str());
+	if(!in)
+		throw Parameter_error("Cannot open config file: " + filename);
+	string line;
+	while(getline(in, line)) {
+		string::size_type hash = line.find('#');
+		if(hash != string::npos)
+			line.erase(hash);
+		vector<string> tokens = tokenize(line);
+		for(vector<string>::size_type i = 0; i < tokens.size(); i++) {
+			string::size_type eq = tokens[i].find('=');
+			if(eq == string::npos || eq == 0)
+				throw Parameter_error("Expected key=value in " + filename + ", got \"" + tokens[i] + "\"");
+			string key = tokens[i].substr(0, eq);
+			if(key == "config")
+				throw Parameter_error("Nested config files are not supported: " + filename);
+			set(key, tokens[i].substr(eq + 1));
+		}
+	}
+}
+
+void Task_parameters::validate() const
+{
+	if(n_trials <= 0)
+		throw Parameter_error("Number of trials must be positive");
+	if(locus_eccentricity < 0)
+		throw Parameter_error("Locus eccentricity must be positive");
+	if(cue_proximity < 0)
+		throw Parameter_error("Cue proximity must be positive");
+	for(vector<long>::size_type i = 0; i < probe_delays.size(); i++)
+		if(probe_delays[i] < 0)
+			throw Parameter_error("Probe delays must not be negative");
+	if(probe_delay_bin < 0)
+		throw Parameter_error("probe_delay_bin must not be negative");
+	Delay_sampler sampler;
+	build_delay_sampler(sampler);
+	if(start_delay < 0 || fixation_duration < 0 || cue_duration < 0 || post_cue_duration < 0
+		|| probe_linger < 0 || intertrial_interval < 0 || shutdown_delay < 0 || saccade_timeout < 0)
+		throw Parameter_error("Phase durations must not be negative");
+	if(spatiotopic_weight < 0 || retinotopic_weight < 0 || intermediate_weight < 0)
+		throw Parameter_error("Trial type weights must not be negative");
+	if(spatiotopic_weight + retinotopic_weight + intermediate_weight <= 0)
+		throw Parameter_error("At least one trial type weight must be positive");
+	if(output_mode == OUTPUT_CSV && output_file.empty())
+		throw Parameter_error("output_file must not be empty");
+	if(output_mode == OUTPUT_CSV && summary && (summary_file.empty() || summary_file == output_file))
+		throw Parameter_error("summary_file must be set and differ from output_file");
+	if(winsor < 0. || winsor >= .5)
+		throw Parameter_error("winsor must be in [0, 0.5)");
+	if(bootstrap < 0 || bootstrap_threads < 0)
+		throw Parameter_error("bootstrap and bootstrap_threads must not be negative");
+	if(output_mode == OUTPUT_CSV && bootstrap > 0 && (bootstrap_file.empty() || bootstrap_file == output_file
+		|| (summary && bootstrap_file == summary_file)))
+		throw Parameter_error("bootstrap_file must be set and differ from the other output files");
+	if(output_mode == OUTPUT_CSV && timing && (timing_file.empty() || timing_file == output_file
+		|| (summary && timing_file == summary_file) || (bootstrap > 0 && timing_file == bootstrap_file)))
+		throw Parameter_error("timing_file must be set and differ from the other output files");
+	if(status_interval < 0)
+		throw Parameter_error("status_interval must not be negative");
+	if(trace_size < 0)
+		throw Parameter_error("trace_size must not be negative");
+	if(trace_size > 0 && trace_file.empty())
+		throw Parameter_error("trace_file must not be empty");
+	if(shard < -1)
+		throw Parameter_error("shard must be a worker number, or -1 for unsharded output");
+	if(run_id < 0)
+		throw Parameter_error("run_id must not be negative");
+	// every shard would otherwise number its runs from 1 and the merge would drop them as duplicates
+	if(shard >= 0 && run_id == 0)
+		throw Parameter_error("A sharded run needs run_id, the sweep-wide id of its first run");
+}
+
+string Task_parameters::describe() const
+{
+	ostringstream oss;
+	oss << " Trials             : " << n_trials << endl;
+	oss << " Locus Eccentricity : " << locus_eccentricity << " DVA" << endl;
+	oss << " Cue Proximity      : " << cue_proximity << " DVA" << endl;
+	oss << " Tag                : " << tag << endl;
+	oss << " Probe Delays (ms)  : ";
+	const vector<long>& delays = (probe_delay_mode == DELAY_DISCRETE) ? probe_delays
+		: (probe_delay_mode == DELAY_UNIFORM) ? probe_delay_range : probe_delay_edges;
+	oss << ((probe_delay_mode == DELAY_DISCRETE) ? "set" : (probe_delay_mode == DELAY_UNIFORM) ? "uniform" : "histogram edges");
+	for(vector<long>::size_type i = 0; i < delays.size(); i++)
+		oss << (i ? "," : " ") << delays[i];
+	if(!probe_delay_weights.empty()) {
+		oss << ", weights";
+		for(vector<double>::size_type i = 0; i < probe_delay_weights.size(); i++)
+			oss << (i ? "," : " ") << probe_delay_weights[i];
+	}
+	if(probe_delay_bin > 0)
+		oss << ", binned every " << probe_delay_bin << "ms";
+	oss << endl;
+	if(!saccade)
+		oss << " Saccade            : none (no-saccade control)" << endl;
+	if(probe_distractors)
+		oss << " Probe Distractors  : at the other candidate probe locations" << endl;
+	oss << " Phases (ms)        : start " << start_delay << ", fixation " << fixation_duration
+		<< ", cue " << cue_duration << ", post-cue " << post_cue_duration
+		<< ", probe linger " << probe_linger << ", ITI " << intertrial_interval
+		<< ", shutdown " << shutdown_delay << endl;
+	oss << " Saccade Timeout    : ";
+	if(saccade_timeout)
+		oss << saccade_timeout << "ms" << endl;
+	else
+		oss << "none" << endl;
+	oss << " Trial Type Weights : spatiotopic " << spatiotopic_weight << ", retinotopic " << retinotopic_weight
+		<< ", intermediate " << intermediate_weight << endl;
+	oss << " Seed               : ";
+	if(seed)
+		oss << seed << endl;
+	else
+		oss << "random" << endl;
+	oss << " Output             : " << (output_mode == OUTPUT_CSV ? shard_file(output_file) + ".csv" : string("none")) << endl;
+	if(output_mode == OUTPUT_CSV && summary) {
+		oss << " Summary            : " << shard_file(summary_file) << ".csv";
+		if(winsor > 0.)
+			oss << ", RT winsorized at " << winsor;
+		oss << endl;
+	}
+	if(output_mode == OUTPUT_CSV && bootstrap > 0)
+		oss << " Bootstrap CIs      : " << shard_file(bootstrap_file) << ".csv, " << bootstrap << " resamples" << endl;
+	if(output_mode == OUTPUT_CSV && timing)
+		oss << " Trial Timing       : " << shard_file(timing_file) << ".csv" << endl;
+	if(!status_file.empty())
+		oss << " Status File        : " << status_file << endl;
+	if(trace_size > 0)
+		oss << " Event Trace        : last " << trace_size << " events, dumped to " << shard_file(trace_file) << ".trace" << endl;
+	if(shard >= 0)
+		oss << " Shard              : " << shard << ", first run id " << run_id << endl;
+	return oss.str();
+}
+
+string Task_parameters::shard_file(const string& base) const
+{
+	if(shard < 0)
+		return base;
+	ostringstream oss;
+	oss << base << "_shard" << shard;
+	return oss.str();
+}
+
+void Task_parameters::build_delay_sampler(Delay_sampler& sampler) const
+{
+	try {
+		switch(probe_delay_mode) {
+			case DELAY_DISCRETE:
+				sampler.set_discrete(probe_delays, probe_delay_weights);
+				break;
+			case DELAY_UNIFORM:
+				if(probe_delay_range.size() != 2)
+					throw Parameter_error("probe_delay_range needs exactly two values: lo,hi");
+				if(!probe_delay_weights.empty())
+					throw Parameter_error("probe_delay_weights does not apply to a uniform range");
+				sampler.set_uniform(probe_delay_range[0], probe_delay_range[1]);
+				break;
+			default:
+				sampler.set_histogram(probe_delay_edges, probe_delay_weights);
+				break;
+		}
+	}
+	catch(invalid_argument& x) {
+		throw Parameter_error(x.what());
+	}
+}
@@ -0,0 +1,117 @@
+#ifndef TASK_PARAMETERS_H
+#define TASK_PARAMETERS_H
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+class Delay_sampler;
+
+/*
+Task_parameters holds every configurable factor of the retinotopic task.
+It is filled from the device condition string once, validated, and then
+only read by the device - restarting a run never reparses anything.
+
+Condition string syntax: whitespace- or ';'-separated key=value tokens,
+list values separated by commas, e.g.
+
+	n_trials=200 locus_eccentricity=4.15 probe_delays=50,250,400 seed=7
+
+For backwards compatibility the string may start with the old positional
+fields "trials locus_width cue_proximity [tag]", optionally followed by
+key=value tokens. The positional locus_width is a full width, so it is
+halved to give the eccentricity (locus_width=W is accepted as a key too).
+config=<file> reads further key=value lines from a file ('#' comments).
+
+Probe delays are drawn by a Delay_sampler according to probe_delay_mode:
+	discrete   probe_delays=50,250,400 [probe_delay_weights=1,2,1]
+	uniform    probe_delay_range=0,600
+	histogram  probe_delay_edges=0,100,300,600 [probe_delay_weights=2,1,1]
+probe_delay_bin=W groups the delays into W ms statistics cells
+(0 = one cell per delay of the set, per histogram bin, or for the range).
+*/
+
+// thrown for any malformed or out-of-range parameter
+class Parameter_error : public std::runtime_error {
+public:
+	Parameter_error(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+struct Task_parameters {
+	enum Output_mode_e {OUTPUT_CSV, OUTPUT_NONE};
+
+	// design
+	int n_trials;                 //trials in the run
+	double locus_eccentricity;    //distance of the attention loci from 0,0 in DVA
+	double cue_proximity;         //offset of the cue from the initial fixation in DVA
+	std::string tag;              //any info, written to output with the data
+
+	// probe delay distribution, ms after saccade completion
+	enum Delay_mode_e {DELAY_DISCRETE, DELAY_UNIFORM, DELAY_HISTOGRAM};
+	Delay_mode_e probe_delay_mode;
+	std::vector<long> probe_delays;           //discrete delay set
+	std::vector<long> probe_delay_range;      //uniform lo,hi
+	std::vector<long> probe_delay_edges;      //histogram bin edges
+	std::vector<double> probe_delay_weights;  //per delay or per bin; empty = equal
+	long probe_delay_bin;                     //statistics cell width, 0 = natural cells
+
+	bool saccade;                 //false = no-saccade control, fixation holds until the probe
+	bool probe_distractors;       //also show distractors at the other candidate probe locations
+
+	// phase durations (ms)
+	long start_delay;             //Start event to first trial
+	long fixation_duration;       //initial fixation before the cue
+	long cue_duration;
+	long post_cue_duration;       //cue offset to saccade target onset
+	long probe_linger;            //keystroke to probe removal
+	long intertrial_interval;
+	long shutdown_delay;
+	long saccade_timeout;         //abandon the trial if no eye movement by then, 0 = wait forever
+
+	// relative trial type frequencies
+	double spatiotopic_weight;
+	double retinotopic_weight;
+	double intermediate_weight;
+
+	// run control
+	unsigned long seed;           //0 = seed from the system entropy source
+	Output_mode_e output_mode;
+	std::string output_file;      //data file name without the .csv extension
+	bool summary;                 //write the end-of-run summary table (csv output only)
+	std::string summary_file;     //summary file name without the .csv extension
+	double winsor;                //winsorize RT at this tail fraction for the summary, 0 = off
+	bool timing;                  //write each trial's timing vector at the end of a run (csv output only)
+	std::string timing_file;      //timing file name without the .csv extension
+	int bootstrap;                //resamples for facilitation CIs at the end of a run, 0 = off
+	int bootstrap_threads;        //0 = one per hardware thread
+	std::string bootstrap_file;   //bootstrap CI file name without the .csv extension
+	bool show_debug;              //verbose per-phase trace messages
+	std::string status_file;      //live progress file (see Run_metrics), empty = none
+	int status_interval;          //rewrite the status file every N trials, 0 = start/stop only
+	int trace_size;               //events kept by the event trace (see Event_trace), 0 = off
+	std::string trace_file;       //event trace dump name without the .trace extension
+	int shard;                    //worker number for sharded output (see Shard_merge.h), -1 = unsharded
+	long run_id;                  //sweep-wide id of the next run, required with shard; 0 = start from 1
+
+	Task_parameters();
+
+	// parse a condition string over the defaults (or over the given base
+	// settings, e.g. a task variant preset), then validate;
+	// throws Parameter_error and leaves *this unchanged on failure
+	void parse(const std::string& condition_string);
+	void parse(const std::string& condition_string, const Task_parameters& base);
+	// throws Parameter_error describing the first invalid field
+	void validate() const;
+	// one line per parameter, for the device banner
+	std::string describe() const;
+	// configure a sampler for the probe delay distribution
+	void build_delay_sampler(Delay_sampler& sampler) const;
+	// an output file name (without extension) as actually used: base_shard<N> when sharded
+	std::string shard_file(const std::string& base) const;
+
+private:
+	void set(const std::string& key, const std::string& value);
+	void read_file(const std::string& filename);
+};
+
+#endif
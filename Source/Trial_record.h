@@ -0,0 +1,61 @@
+#ifndef TRIAL_RECORD_H
+#define TRIAL_RECORD_H
+
+#include <stdint.h>
+
+/*
+Trial_record is the compact per-trial row the device keeps in memory for
+its end-of-run analyses (Trial_summary and friends); the text rows in
+data_output.csv carry the same values.
+
+Trial_timing is the trial's full timing vector: the simulated time of
+every display change, eye movement and the keystroke, in ms from the
+trial onset (initial fixation appearance), or not_reached_c if the trial
+never got there (e.g. no saccade target in the no-saccade control). The
+device writes every trial's vector to timing_output.csv when a run ends.
+*/
+
+struct Trial_timing {
+	enum Point_e {FIXATION_ON, CUE_ON, CUE_OFF, FIXATION_OFF, TARGET_ON, SACCADE_START, SACCADE_END,
+		TARGET_OFF, PROBE_ON, KEYSTROKE, PROBE_OFF, n_points_c};
+	static const int32_t not_reached_c = -1;
+
+	int64_t onset;              //simulated time of FIXATION_ON (ms)
+	int32_t at[n_points_c];     //ms after onset
+
+	void start(long time)
+		{
+			onset = time;
+			for(int i = 0; i < n_points_c; i++)
+				at[i] = not_reached_c;
+			at[FIXATION_ON] = 0;
+		}
+	void mark(Point_e point, long time)
+		{at[point] = static_cast<int32_t>(time - onset);}
+
+	// ms from one point to a later one, or not_reached_c if either is missing
+	int32_t interval(Point_e from, Point_e to) const
+		{return (at[from] == not_reached_c || at[to] == not_reached_c) ? not_reached_c : at[to] - at[from];}
+	int32_t saccade_latency() const
+		{return interval(TARGET_ON, SACCADE_START);}
+	int32_t movement_time() const
+		{return interval(SACCADE_START, SACCADE_END);}
+};
+
+struct Trial_record {
+	int32_t trial;
+	int32_t probe_delay;        //ms after saccade completion
+	int32_t rt;                 //ms from probe onset to keystroke
+	int32_t saccade_duration;   //ms from saccade target onset to eye movement end
+	int8_t trial_type;          //0 spatiotopic, 1 retinotopic, 2 intermediate
+	int8_t correct;             //1 if the keystroke matched the probe
+	Trial_timing timing;
+
+	// the first trial of a run is practice and left out of every RT statistic:
+	// the running averages, the cell statistics, Trial_summary and the bootstrap
+	static const int32_t first_analyzed_trial_c = 2;
+	bool is_analyzed() const
+		{return trial >= first_analyzed_trial_c;}
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "Trial_summary.h"
+#include "Statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <iomanip>
+
+using namespace std;
+
+namespace {
+
+const double pi_c = 3.14159265358979323846;
+
+// quantile x of the standard normal with P(X < x) = p (Acklam's rational approximation)
+double normal_quantile(double p)
+{
+	static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+		1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+	static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+		6.680131188771972e+01, -1.328068155288572e+01};
+	static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+		-2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+	static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+		3.754408661907416e+00};
+	const double p_low = 0.02425;
+
+	if(p < p_low) {
+		double q = sqrt(-2 * log(p));
+		return (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+			((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+	}
+	if(p > 1 - p_low) {
+		double q = sqrt(-2 * log(1 - p));
+		return -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+			((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+	}
+	double q = p - 0.5;
+	double r = q * q;
+	return (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*q /
+		(((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1);
+}
+
+// R's default (type 7) sample quantile of sorted data
+double quantile7(const vector<double>& sorted, double p)
+{
+	double h = (sorted.size() - 1) * p;
+	vector<double>::size_type lo = static_cast<vector<double>::size_type>(floor(h));
+	vector<double>::size_type hi = min(lo + 1, sorted.size() - 1);
+	return sorted[lo] + (h - lo) * (sorted[hi] - sorted[lo]);
+}
+
+} // namespace
+
+Trial_summary::Trial_summary(const vector<long>& bin_starts_, double winsor_fraction_, double confidence_) :
+	bin_starts(bin_starts_), winsor_fraction(winsor_fraction_), confidence(confidence_)
+{
+	if(bin_starts.empty())
+		bin_starts.push_back(0);
+}
+
+vector<Summary_cell> Trial_summary::summarize(const vector<Trial_record>& records) const
+{
+	vector<Summary_cell> cells;
+	if(records.empty())
+		return cells;
+
+	// winsorize over all analyzed trials, before dropping errors, as the R script did
+	double lo, hi;
+	winsor_limits(records, winsor_fraction, lo, hi);
+
+	int n_types = 0;
+	for(vector<Trial_record>::size_type i = 0; i < records.size(); i++)
+		n_types = max(n_types, records[i].trial_type + 1);
+
+	Cell_statistics stats;
+	stats.configure(n_types, bin_starts);
+	for(vector<Trial_record>::size_type i = 0; i < records.size(); i++) {
+		const Trial_record& r = records[i];
+		if(!r.correct || !r.is_analyzed())
+			continue;
+		stats.update(r.trial_type, r.probe_delay, min(max(double(r.rt), lo), hi));
+	}
+
+	// Morey correction uses the number of within-subject conditions observed
+	vector<bool> type_seen(n_types, false), bin_seen(stats.get_n_bins(), false);
+	for(int row = 0; row < n_types; row++)
+		for(int bin = 0; bin < stats.get_n_bins(); bin++)
+			if(stats.get_cell(row, bin).get_n() > 0)
+				type_seen[row] = bin_seen[bin] = true;
+	int n_conditions = static_cast<int>(count(type_seen.begin(), type_seen.end(), true)
+		* count(bin_seen.begin(), bin_seen.end(), true));
+	double correction = (n_conditions > 1) ? sqrt(n_conditions / (n_conditions - 1.)) : 1.;
+
+	for(int row = 0; row < n_types; row++) {
+		for(int bin = 0; bin < stats.get_n_bins(); bin++) {
+			const Current_variance& cell = stats.get_cell(row, bin);
+			if(cell.get_n() == 0)
+				continue;
+			Summary_cell s;
+			s.trial_type = row;
+			s.probe_delay = stats.get_bin_start(bin);
+			s.n = cell.get_n();
+			s.mean = cell.get_mean();
+			s.sd = cell.get_sd() * correction;
+			s.se = cell.get_se() * correction;
+			s.ci = (s.n > 1) ? s.se * t_quantile(confidence / 2. + .5, s.n - 1) : 0.;
+			cells.push_back(s);
+		}
+	}
+	return cells;
+}
+
+void Trial_summary::winsor_limits(const vector<Trial_record>& records, double fraction, double& lo, double& hi)
+{
+	lo = -HUGE_VAL;
+	hi = HUGE_VAL;
+	if(fraction <= 0. || records.empty())
+		return;
+	vector<double> sorted;
+	sorted.reserve(records.size());
+	for(vector<Trial_record>::size_type i = 0; i < records.size(); i++)
+		if(records[i].is_analyzed())
+			sorted.push_back(records[i].rt);
+	if(sorted.empty())
+		return;
+	sort(sorted.begin(), sorted.end());
+	lo = quantile7(sorted, fraction);
+	hi = quantile7(sorted, 1. - fraction);
+}
+
+string Trial_summary::csv_header()
+{
+	return "TRIAL_TYPE,PROBE_DELAY,N,RT,SD,SE,CI";
+}
+
+void Trial_summary::write_csv(ostream& os, const vector<Summary_cell>& cells,
+	const string* trial_type_names, const string& prefix)
+{
+	ios::fmtflags flags = os.flags();
+	streamsize precision = os.precision();
+	os << fixed << setprecision(3);
+	for(vector<Summary_cell>::size_type i = 0; i < cells.size(); i++) {
+		const Summary_cell& c = cells[i];
+		os << prefix << trial_type_names[c.trial_type] << "," << c.probe_delay << "," << c.n << ","
+			<< c.mean << "," << c.sd << "," << c.se << "," << c.ci << endl;
+	}
+	os.flags(flags);
+	os.precision(precision);
+}
+
+// Hill's algorithm 396 (CACM 1970), using the normal quantile for large df
+double Trial_summary::t_quantile(double lower_tail, int df)
+{
+	if(lower_tail == .5)
+		return 0.;
+	double sign = (lower_tail > .5) ? 1. : -1.;
+	double p = 2. * min(lower_tail, 1. - lower_tail);	//two-tailed probability
+	double n = df;
+	double t;
+
+	if(df == 1)
+		t = 1. / tan(p * pi_c / 2.);
+	else if(df == 2)
+		t = sqrt(2. / (p * (2. - p)) - 2.);
+	else {
+		double a = 1. / (n - .5);
+		double b = 48. / (a * a);
+		double c = ((20700. * a / b - 98.) * a - 16.) * a + 96.36;
+		double d = ((94.5 / (b + c) - 3.) / b + 1.) * sqrt(a * pi_c / 2.) * n;
+		double x = d * p;
+		double y = pow(x, 2. / n);
+		if(y > .05 + a) {
+			x = normal_quantile(p * .5);
+			y = x * x;
+			if(df < 5)
+				c += .3 * (n - 4.5) * (x + .6);
+			c = (((.05 * d * x - 5.) * x - 7.) * x - 2.) * x + b + c;
+			y = (((((.4 * y + 6.3) * y + 36.) * y + 94.5) / c - y - 3.) / b + 1.) * x;
+			y = a * y * y;
+			y = (y > .002) ? exp(y) - 1. : .5 * y * y + y;
+		}
+		else
+			y = ((1. / (((n + 6.) / (n * y) - .089 * d - .822) * (n + 2.) * 3.) + .5 / (n + 4.)) * y - 1.)
+				* (n + 1.) / (n + 2.) + 1. / y;
+		t = sqrt(n * y);
+	}
+	return sign * t;
+}
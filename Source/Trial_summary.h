@@ -0,0 +1,59 @@
+#ifndef TRIAL_SUMMARY_H
+#define TRIAL_SUMMARY_H
+
+#include <vector>
+#include <string>
+#include <iosfwd>
+
+#include "Trial_record.h"
+
+/*
+Trial_summary computes the RT summary our R post-processing used to do:
+optionally winsorize RT over all analyzed trials (as psych::winsor, type 7
+quantiles), keep only correct trials, then per TRIAL_TYPE x PROBE_DELAY
+cell report N, mean, and the sd, se and confidence interval of
+summarySEwithin - which for a single run is the plain summary scaled by
+the Morey correction sqrt(M / (M - 1)), M = number of cells.
+Probe delays are grouped into the cells given by their lower bounds
+(see Cell_statistics), so each cell's PROBE_DELAY is its bin start.
+Like the running averages, it leaves out each run's first trial
+(Trial_record::is_analyzed()).
+*/
+
+struct Summary_cell {
+	int trial_type;
+	long probe_delay;
+	int n;
+	double mean;
+	double sd;
+	double se;
+	double ci;
+};
+
+class Trial_summary {
+public:
+	Trial_summary(const std::vector<long>& bin_starts_, double winsor_fraction_ = 0., double confidence_ = .95);
+
+	// cells in trial type, then delay order; empty cells are omitted
+	std::vector<Summary_cell> summarize(const std::vector<Trial_record>& records) const;
+
+	// column names written by write_csv after the prefix, without a line end
+	static std::string csv_header();
+	// one row per cell, prefixed by the given provenance fields (already comma-terminated)
+	static void write_csv(std::ostream& os, const std::vector<Summary_cell>& cells,
+		const std::string* trial_type_names, const std::string& prefix);
+
+	// RT limits for winsorizing the analyzed records at fraction in each tail (type 7 quantiles);
+	// fraction 0 gives unbounded limits
+	static void winsor_limits(const std::vector<Trial_record>& records, double fraction, double& lo, double& hi);
+
+	// value below which 100 * lower_tail percent of Student's t with df degrees of freedom lies
+	static double t_quantile(double lower_tail, int df);
+
+private:
+	std::vector<long> bin_starts;
+	double winsor_fraction;
+	double confidence;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "Visual_object_pool.h"
+
+using namespace std;
+
+
+int Visual_object_pool::add(const Symbol& name, GU::Point location, GU::Size size, const Symbol& shape,
+	const Symbol& color, const Symbol& orientation, int kind)
+{
+	names.push_back(name);
+	locations.push_back(location);
+	sizes.push_back(size);
+	shapes.push_back(shape);
+	colors.push_back(color);
+	orientations.push_back(orientation);
+	kinds.push_back(kind);
+	visible.push_back(0);
+	return static_cast<int>(names.size()) - 1;
+}
+
+// clear() keeps the capacity of every column
+void Visual_object_pool::clear()
+{
+	names.clear();
+	locations.clear();
+	sizes.clear();
+	shapes.clear();
+	colors.clear();
+	orientations.clear();
+	kinds.clear();
+	visible.clear();
+}
+
+void Visual_object_pool::reserve(int n)
+{
+	names.reserve(n);
+	locations.reserve(n);
+	sizes.reserve(n);
+	shapes.reserve(n);
+	colors.reserve(n);
+	orientations.reserve(n);
+	kinds.reserve(n);
+	visible.reserve(n);
+}
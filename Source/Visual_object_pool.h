@@ -0,0 +1,70 @@
+#ifndef VISUAL_OBJECT_POOL_H
+#define VISUAL_OBJECT_POOL_H
+
+#include <vector>
+
+#include "EPICLib/Symbol.h"
+#include "EPICLib/Geometry.h"
+
+namespace GU = Geometry_Utilities;
+
+/*
+Visual_object_pool holds the visual objects of one trial's display in
+contiguous columns (name, location, size, shape, color, orientation), so
+the device can present or remove a group of objects - e.g. a probe with
+its distractors - as one pass over each column. Objects are added in
+display order and addressed by index; clear() empties the pool for the
+next trial but keeps its storage, so a display of dozens of objects costs
+no allocation once the pool has grown to fit it.
+
+Each object also carries a small integer kind chosen by the owner (the
+device uses its event trace label), and a visible flag.
+*/
+
+class Visual_object_pool {
+public:
+	Visual_object_pool() {}
+
+	// returns the new object's index; an empty orientation Symbol means none is set
+	int add(const Symbol& name, GU::Point location, GU::Size size, const Symbol& shape, const Symbol& color,
+		const Symbol& orientation = Symbol(), int kind = 0);
+	void clear();
+	void reserve(int n);
+
+	int size() const
+		{return static_cast<int>(names.size());}
+
+	const Symbol& get_name(int i) const
+		{return names[i];}
+	GU::Point get_location(int i) const
+		{return locations[i];}
+	GU::Size get_size(int i) const
+		{return sizes[i];}
+	const Symbol& get_shape(int i) const
+		{return shapes[i];}
+	const Symbol& get_color(int i) const
+		{return colors[i];}
+	const Symbol& get_orientation(int i) const
+		{return orientations[i];}
+	bool has_orientation(int i) const
+		{return orientations[i] != Symbol();}
+	int get_kind(int i) const
+		{return kinds[i];}
+
+	bool is_visible(int i) const
+		{return visible[i] != 0;}
+	void set_visible(int i, bool visible_)
+		{visible[i] = visible_;}
+
+private:
+	std::vector<Symbol> names;
+	std::vector<GU::Point> locations;
+	std::vector<GU::Size> sizes;
+	std::vector<Symbol> shapes;
+	std::vector<Symbol> colors;
+	std::vector<Symbol> orientations;
+	std::vector<int> kinds;
+	std::vector<char> visible;
+};
+
+#endif
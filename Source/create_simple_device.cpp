@@ -1,11 +1,47 @@
 #include "EPICLib/Output_tee_globals.h"
 #include "simple_device.h"
 
+#include <cstring>
+
+/*
+Task variants built into this library. Each is the same simple_device
+with a different parameter preset; the condition string given at run
+time is parsed over the preset, so any setting can still be overridden.
+The first entry is what create_device() builds.
+*/
+namespace {
+
+struct Device_variant {
+	const char* name;
+	const char* device_name;
+	const char* parameters;
+};
+
+const Device_variant variants_c[] = {
+	{"Retinotopic", "Simple Device", ""},
+	{"Spatiotopic_only", "Simple Device (Spatiotopic_only)", "retinotopic_weight=0 intermediate_weight=0"},
+	// without a saccade every candidate probe location is the cue, so all trials are one type
+	{"No_saccade", "Simple Device (No_saccade)", "saccade=0 retinotopic_weight=0 intermediate_weight=0"}
+};
+const int n_variants_c = sizeof(variants_c) / sizeof(variants_c[0]);
+
+}
 
 // for use in non-dynamically loaded models
 Device_base * create_simple_device()
 {
-	return new simple_device("Simple Device", Normal_out);
+	return new simple_device(variants_c[0].device_name, Normal_out, variants_c[0].parameters);
+}
+
+// returns 0 if there is no variant by that name; a null name gives the default variant
+Device_base * create_simple_device_variant(const char * variant_name)
+{
+	if(!variant_name)
+		return create_simple_device();
+	for(int i = 0; i < n_variants_c; i++)
+		if(std::strcmp(variants_c[i].name, variant_name) == 0)
+			return new simple_device(variants_c[i].device_name, Normal_out, variants_c[i].parameters);
+	return 0;
 }
 
 // the class factory functions to be accessed with dlsym
@@ -14,6 +50,22 @@ extern "C" Device_base * create_device()
     return create_simple_device();
 }
 
+extern "C" Device_base * create_device_variant(const char * variant_name) 
+{
+    return create_simple_device_variant(variant_name);
+}
+
+extern "C" int device_variant_count() 
+{
+    return n_variants_c;
+}
+
+// returns 0 if index is out of range
+extern "C" const char * device_variant_name(int index) 
+{
+    return (index >= 0 && index < n_variants_c) ? variants_c[index].name : 0;
+}
+
 extern "C" void destroy_device(Device_base * p) 
 {
     delete p;
@@ -0,0 +1,154 @@
+/*
+device_tests - regression checks for the device, run without EPIC.
+
+	device_tests [-record] manifest
+
+Runs every golden-output case in the manifest (see Golden_harness.h) and
+compares its transcript with the stored golden file; with -record the
+transcripts are written as the new golden files instead. Then checks that
+Bootstrap_engine gives identical intervals on 1 thread and on several, and
+that merge_shards (see Shard_merge.h) fills gaps, drops duplicate runs and
+copes with a rerun appended to a shard.
+
+Exit status: 0 if every check passed, 1 if any failed, 2 for bad arguments.
+*/
+
+#include "Golden_harness.h"
+#include "Bootstrap_engine.h"
+#include "Random_draws.h"
+#include "Shard_merge.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+
+using namespace std;
+
+namespace {
+
+const char* const usage_c = "usage: device_tests [-record] manifest";
+
+bool same_intervals(const vector<Bootstrap_interval>& a, const vector<Bootstrap_interval>& b)
+{
+	if(a.size() != b.size())
+		return false;
+	for(vector<Bootstrap_interval>::size_type i = 0; i < a.size(); i++)
+		if(a[i].probe_delay != b[i].probe_delay || a[i].type_a != b[i].type_a || a[i].type_b != b[i].type_b
+			|| a[i].estimate != b[i].estimate || a[i].lower != b[i].lower || a[i].upper != b[i].upper)
+			return false;
+	return true;
+}
+
+// the intervals must depend only on the seed, never on the number of threads;
+// returns the number of failures
+int check_bootstrap_threads(ostream& report)
+{
+	const long delays[] = {50, 250, 400};
+	mt19937 rng(1);
+	vector<Trial_record> records;
+	for(int i = 1; i <= 600; i++) {
+		Trial_record r = Trial_record();
+		r.trial = i;
+		r.trial_type = static_cast<int8_t>(random_below(rng, 3));
+		r.probe_delay = static_cast<int32_t>(delays[random_below(rng, 3)]);
+		r.rt = static_cast<int32_t>(random_between(rng, 300, 600));
+		r.correct = random_unit(rng) < .9;
+		records.push_back(r);
+	}
+	Bootstrap_engine engine(records, vector<long>(delays, delays + 3));
+
+	// 2000 resamples is 32 blocks, enough to share out unevenly
+	vector<Bootstrap_interval> single = engine.run(2000, 7, 1);
+	const int thread_counts[] = {2, 3, 8};
+	int n_failures = 0;
+	for(int i = 0; i < 3; i++) {
+		if(same_intervals(single, engine.run(2000, 7, thread_counts[i])))
+			report << "ok   bootstrap on " << thread_counts[i] << " threads" << endl;
+		else {
+			report << "FAIL bootstrap on " << thread_counts[i] << " threads: intervals differ from 1 thread" << endl;
+			n_failures++;
+		}
+	}
+	return n_failures;
+}
+
+// up to three shards, merged and compared with the expected output; a null
+// merged means the merge must fail, and what it wrote does not matter
+struct Merge_case {
+	const char* name;
+	const char* shards[3];
+	long expected_runs;
+	int status;
+	const char* merged;
+};
+
+#define MERGE_HEADER "SHARD,RUN_ID,TRIAL,RT\n"
+
+const Merge_case merge_cases_c[] = {
+	{"interleaved", {MERGE_HEADER "0,1,1,300\n0,1,2,310\n0,3,1,320\n", MERGE_HEADER "1,2,1,400\n1,2,2,410\n", 0}, 3, 0,
+		MERGE_HEADER "0,1,1,300\n0,1,2,310\n1,2,1,400\n1,2,2,410\n0,3,1,320\n"},
+	{"gaps", {MERGE_HEADER "0,1,1,300\n0,4,1,330\n", MERGE_HEADER "1,2,1,400\n", 0}, 5, 1,
+		MERGE_HEADER "0,1,1,300\n1,2,1,400\n0,4,1,330\n"},
+	{"duplicate across shards", {MERGE_HEADER "0,1,1,300\n0,2,1,310\n", MERGE_HEADER "1,2,1,400\n1,3,1,410\n", 0}, 3, 1,
+		MERGE_HEADER "0,1,1,300\n0,2,1,310\n1,3,1,410\n"},
+	{"rerun appended", {MERGE_HEADER "0,1,1,300\n0,2,1,310\n0,1,1,900\n0,2,1,910\n0,3,1,920\n",
+		MERGE_HEADER "1,4,1,400\n", 0}, 4, 1,
+		MERGE_HEADER "0,1,1,300\n0,2,1,310\n0,3,1,920\n1,4,1,400\n"},
+	{"run repeated back to back", {MERGE_HEADER "0,1,1,300\n0,1,2,310\n0,1,1,900\n0,1,2,910\n", 0, 0}, 1, 1,
+		MERGE_HEADER "0,1,1,300\n0,1,2,310\n"},
+	{"empty shard", {MERGE_HEADER "0,1,1,300\n", MERGE_HEADER, 0}, 0, 1,
+		MERGE_HEADER "0,1,1,300\n"},
+	{"different headers", {MERGE_HEADER "0,1,1,300\n", "SHARD,RUN_ID,RT\n1,2,400\n", 0}, 0, 2, 0},
+	{"bad run id", {MERGE_HEADER "0,1,1,300\n0,x,1,310\n", 0, 0}, 0, 2, 0}
+};
+const int n_merge_cases_c = sizeof(merge_cases_c) / sizeof(merge_cases_c[0]);
+
+// returns the number of failures
+int check_shard_merge(ostream& report)
+{
+	int n_failures = 0;
+	for(int c = 0; c < n_merge_cases_c; c++) {
+		const Merge_case& mc = merge_cases_c[c];
+		istringstream files[3];
+		vector<istream*> shards;
+		vector<string> names;
+		for(int i = 0; i < 3 && mc.shards[i]; i++) {
+			files[i].str(mc.shards[i]);
+			shards.push_back(&files[i]);
+			names.push_back(string("shard") + char('0' + i));
+		}
+		ostringstream merged, log;
+		int status = merge_shards(shards, names, merged, log, 1, mc.expected_runs);
+		if(status == mc.status && (!mc.merged || merged.str() == mc.merged))
+			report << "ok   merge " << mc.name << endl;
+		else {
+			report << "FAIL merge " << mc.name << ": status " << status << ", expected " << mc.status << endl;
+			report << log.str() << merged.str();
+			n_failures++;
+		}
+	}
+	return n_failures;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	bool record = false;
+	int arg = 1;
+	if(arg < argc && string(argv[arg]) == "-record") {
+		record = true;
+		arg++;
+	}
+	if(argc - arg != 1) {
+		cerr << usage_c << endl;
+		return 2;
+	}
+
+	int n_failures = run_golden_suite(argv[arg], record, cout);
+	n_failures += check_bootstrap_threads(cout);
+	n_failures += check_shard_merge(cout);
+	return n_failures ? 1 : 0;
+}
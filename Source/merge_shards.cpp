@@ -0,0 +1,102 @@
+/*
+merge_shards - combine the per-worker output shards of a sweep into one file.
+
+	merge_shards [-runs N] [-first_run N] merged.csv shard.csv ...
+
+Merges the shards on RUN_ID and writes the rows to merged.csv under their
+common header, checking that run ids run without gaps from -first_run
+(default 1) up to the last one seen, or through -runs N runs if given.
+Duplicate runs - across shards, or from a rerun appended to a shard - keep
+their first copy. See Shard_merge.h for the rules.
+
+Exit status: 0 if the shards were complete and consistent, 1 if runs were
+missing or duplicated or a shard was empty (the merged file is still
+written), 2 if the shards could not be read or do not match (nothing is
+written). The rows go to merged.csv.tmp, which is renamed to merged.csv
+only when the merge gets to the end, so on status 2 an existing merged.csv
+is left as it was.
+*/
+
+#include "Shard_merge.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+
+const char* const usage_c = "usage: merge_shards [-runs N] [-first_run N] merged.csv shard.csv ...";
+
+bool parse_long(const char* s, long& x)
+{
+	char* end;
+	x = strtol(s, &end, 10);
+	return end != s && *end == '\0';
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	long expected_runs = 0;
+	long first_run = 1;
+	int arg = 1;
+	for(; arg < argc && argv[arg][0] == '-'; arg += 2) {
+		string option = argv[arg];
+		long value;
+		if(arg + 1 >= argc || !parse_long(argv[arg + 1], value) || (option != "-runs" && option != "-first_run")) {
+			cerr << usage_c << endl;
+			return 2;
+		}
+		if(option == "-runs")
+			expected_runs = value;
+		else
+			first_run = value;
+	}
+	if(argc - arg < 2) {
+		cerr << usage_c << endl;
+		return 2;
+	}
+	string merged_filename = argv[arg++];
+	string temp_filename = merged_filename + ".tmp";
+
+	vector<ifstream*> files;
+	vector<istream*> shards;
+	vector<string> shard_names;
+	for(; arg < argc; arg++) {
+		files.push_back(new ifstream(argv[arg]));
+		shards.push_back(files.back());
+		shard_names.push_back(argv[arg]);
+	}
+	int status;
+	ofstream merged(temp_filename.c_str(), ofstream::out | ofstream::trunc);
+	if(!merged) {
+		cerr << temp_filename << ": cannot open for writing" << endl;
+		status = 2;
+	}
+	else {
+		status = merge_shards(shards, shard_names, merged, cerr, first_run, expected_runs);
+		merged.close();
+		if(status != 2 && !merged) {
+			cerr << temp_filename << ": write failed" << endl;
+			status = 2;
+		}
+		if(status == 2)
+			remove(temp_filename.c_str());
+		else if(rename(temp_filename.c_str(), merged_filename.c_str()) != 0) {
+			cerr << merged_filename << ": cannot rename " << temp_filename << " to it" << endl;
+			remove(temp_filename.c_str());
+			status = 2;
+		}
+	}
+	for(vector<ifstream*>::size_type i = 0; i < files.size(); i++)
+		delete files[i];
+	if(status == 2)
+		cerr << "nothing written" << endl;
+	return status;
+}
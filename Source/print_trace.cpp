@@ -0,0 +1,38 @@
+/*
+print_trace - decode event trace dumps as text.
+
+	print_trace dump.trace ...
+
+Devices write a dump of their event trace (see Event_trace.h) to
+<trace_file>.trace when a handler throws. print_trace writes each dump
+given as one line per event, oldest first, preceded by the file name when
+there is more than one.
+
+Exit status: 0 if every file was decoded, 1 if any could not be read or is
+not a trace dump, 2 for bad arguments.
+*/
+
+#include "Event_trace.h"
+
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2) {
+		cerr << "usage: print_trace dump.trace ..." << endl;
+		return 2;
+	}
+
+	int status = 0;
+	for(int arg = 1; arg < argc; arg++) {
+		if(argc > 2)
+			cout << argv[arg] << ":" << endl;
+		if(!Event_trace::print_dump(argv[arg], cout)) {
+			cerr << argv[arg] << ": not a readable event trace dump" << endl;
+			status = 1;
+		}
+	}
+	return status;
+}
@@ -0,0 +1,107 @@
+/*
+run_observer - run the device on its own under a Synthetic_observer.
+
+	run_observer [-seed N] [-miss_rate p] [-error_rate p] [condition string ...]
+
+The remaining arguments are joined into the device's condition string
+(e.g. n_trials=1000 seed=3 output=none). The observer uses the default
+Observer_profile, with -miss_rate and -error_rate overriding its saccade
+miss and wrong-key rates, and draws from -seed (default 1). When the run
+ends the device's metrics snapshot is printed.
+
+Exit status: 0 if the run completed, 1 if the device reported an error -
+including a stall, where nothing is left to deliver but the device has not
+stopped (a missed saccade with no saccade_timeout) - and 2 for bad arguments.
+*/
+
+#include "simple_device.h"
+#include "Synthetic_observer.h"
+#include "EPICLib/Output_tee_globals.h"
+#include "EPICLib/Device_exception.h"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cctype>
+#include <cerrno>
+
+using namespace std;
+
+namespace {
+
+const char* const usage_c = "usage: run_observer [-seed N] [-miss_rate p] [-error_rate p] [condition string ...]";
+
+// a probability, 0 to 1
+bool parse_rate(const char* s, double& x)
+{
+	char* end;
+	x = strtod(s, &end);
+	return end != s && *end == '\0' && x >= 0. && x <= 1.;
+}
+
+// digits only - strtoul alone would take a sign, and wrap a negative value;
+// the observer's generator takes a 32-bit seed, so larger values are refused too
+bool parse_unsigned(const char* s, unsigned long& x)
+{
+	if(!isdigit(static_cast<unsigned char>(s[0])))
+		return false;
+	char* end;
+	errno = 0;
+	x = strtoul(s, &end, 10);
+	return *end == '\0' && errno != ERANGE && x <= 0xFFFFFFFFUL;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	Observer_profile profile;
+	unsigned long seed = 1;
+	int arg = 1;
+	for(; arg < argc && argv[arg][0] == '-'; arg += 2) {
+		string option = argv[arg];
+		const char* value = (arg + 1 < argc) ? argv[arg + 1] : "";	//a missing value fails every parse
+		bool valid;
+		if(option == "-seed")
+			valid = parse_unsigned(value, seed);
+		else if(option == "-miss_rate")
+			valid = parse_rate(value, profile.miss_rate);
+		else if(option == "-error_rate")
+			valid = parse_rate(value, profile.error_rate);
+		else
+			valid = false;
+		if(!valid) {
+			cerr << usage_c << endl;
+			return 2;
+		}
+	}
+	string condition_string;
+	for(; arg < argc; arg++) {
+		if(!condition_string.empty())
+			condition_string += " ";
+		condition_string += argv[arg];
+	}
+
+	try {
+		simple_device device("Simple Device", Normal_out);
+		if(!condition_string.empty())
+			device.set_parameter_string(condition_string);
+		Synthetic_observer observer(profile, seed);
+		observer.run(device);
+
+		Metrics_snapshot m = device.get_metrics().snapshot();
+		cout << "trials_started=" << m.trials_started << endl;
+		cout << "trials_completed=" << m.trials_completed << endl;
+		cout << "correct=" << m.correct << endl;
+		cout << "incorrect=" << m.incorrect << endl;
+		cout << "saccade_timeouts=" << m.saccade_timeouts << endl;
+		cout << "events_processed=" << m.events_processed << endl;
+		cout << "events_dispatched=" << observer.get_events_dispatched() << endl;
+		cout << "sim_time=" << m.sim_time << endl;
+	}
+	catch(Device_exception& x) {
+		cerr << "run_observer: " << x.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -7,7 +7,11 @@
  */
 
 #include "simple_device.h"
+#include "Synthetic_observer.h"
+#include "Trial_summary.h"
+#include "Bootstrap_engine.h"
 #include "Statistics.h"
+#include "Random_draws.h"
 #include "EPICLib/Geometry.h"
 #include "EPICLib/Output_tee_globals.h"
 #include "EPICLib/Output_tee.h"
@@ -23,6 +27,7 @@
 #include <sstream>
 #include <algorithm>
 #include <vector>
+#include <utility>
 //#include <cassert>
 #include <cmath>
 
@@ -36,67 +41,91 @@ const Symbol iFix_c("Init_Fixation");
 const Symbol sFix_c("Saccade_Fixation");
 const Symbol VCue_c("Cue");
 const Symbol VProbe_c("Probe");
+const Symbol Distractor_c("Distractor");
+
+// event trace labels: states in State_e order; the object kinds, then the properties
+const char* const state_labels_c[] = {"START", "START_TRIAL", "PRESENT_CUE", "REMOVE_CUE", "REMOVE_FIXATION",
+	"WAITFOR_EYEMOVE", "PRESENT_PROBE", "WAITING_FOR_RESPONSE", "DISCARD_PROBE", "SHUTDOWN"};
+const int n_state_labels_c = 10;
+enum Trace_label_e {INIT_FIXATION_LABEL, CUE_LABEL, SACCADE_FIXATION_LABEL, PROBE_LABEL, DISTRACTOR_LABEL,
+	SHAPE_LABEL, COLOR_LABEL, ORIENTATION_LABEL};
+const char* const trace_labels_c[] = {"Init_Fixation", "Cue", "Saccade_Fixation", "Probe", "Distractor",
+	"Shape", "Color", "Orientation"};
+const int n_trace_labels_c = 8;
 
 const Symbol retinotopic_c("Retinotopic");
 const Symbol spatiotopic_c("Spatiotopic");
 const Symbol intermediate_c("Intermediate");
+
+// indexed by trial_type_index, same order as the trial type weights
+const Symbol trial_types_c[] = {spatiotopic_c, retinotopic_c, intermediate_c};
+const int n_trial_types_c = 3;
+const std::string trial_type_names_c[] = {"Spatiotopic", "Retinotopic", "Intermediate"};
 	
 // experiment constants
 const GU::Size wstim_size_c(1., 1.);
 //const GU::Point vstim_location_c(1., 0.);
 const GU::Size vstim_size_c(1., 1.);
-const long intertrialinterval_c = 5000;
 
-const bool show_debug = true;
 const bool show_states = false;
 
-std::string dataHeader = "\nTASKTYPE,TRIAL,TRIAL_TYPE,PROBE_DELAY,RT,SACCADE_DURATION,ORIENTATION,RESPONSE,CORRECTRESPONSE,ACCURACY,TAG,RULES";
+// new columns go at the end, so scripts that read the older columns by position keep working
+std::string dataHeader = "\nTASKTYPE,TRIAL,TRIAL_TYPE,PROBE_DELAY,RT,SACCADE_DURATION,ORIENTATION,RESPONSE,CORRECTRESPONSE,ACCURACY,TAG,RULES,SACCADE_LATENCY,MOVEMENT_TIME";
+std::string summaryHeader = "TAG,RULES,SEED,";	// followed by the Trial_summary columns
+std::string timingHeader = "TRIAL,TRIAL_TYPE,ONSET";	// followed by one column per Trial_timing point
+// indexed by Trial_timing::Point_e
+const std::string timing_point_names_c[Trial_timing::n_points_c] = {"FIXATION_ON", "CUE_ON", "CUE_OFF", "FIXATION_OFF",
+	"TARGET_ON", "SACCADE_START", "SACCADE_END", "TARGET_OFF", "PROBE_ON", "KEYSTROKE", "PROBE_OFF"};
+std::string shardHeader = "SHARD,RUN_ID,";		// leads every header of sharded output, see Shard_merge.h
 
-simple_device::simple_device(const std::string& device_name, Output_tee& ot) :
+simple_device::simple_device(const std::string& device_name, Output_tee& ot, const std::string& variant_parameters) :
 		Device_base(device_name, ot), 
-        n_total_trials(0), condition_string("10 8.3 2.5 Draft"), locus_eccentricity(0), cue_proximity(0), n_trials(0), trial(0), vresponse_made(false), tagstr("Draft"),
-	state(START) //should this be in initialize? (tls)
+	state(START), //should this be in initialize? (tls)
+        run_seed(0), trial(0), vresponse_made(false),
+        observer(0), recorder(0), saccade_deadline(0), needs_setup(true), run_id(1),
+        init_fix_object(0), cue_object(0), sacc_fix_object(0), probe_object(0), n_probe_objects(0),
+        condition_string("10 8.3 2.5 Draft")
 {
-	// parse condition string and initialize the task
+	try {
+		variant_defaults.parse(variant_parameters);
+	}
+	catch(Parameter_error& x) {
+		throw Device_exception(this, string("Incorrect task variant parameters: ") + x.what());
+	}
+	event_trace.set_labels(state_labels_c, n_state_labels_c, trace_labels_c, n_trace_labels_c);
+	
+	// parse the default condition string; the task is set up at the first Start,
+	// so a condition string set before then decides the seed and the output file
 	parse_condition_string();		
-	initialize();
 }
 
 
 void simple_device::parse_condition_string()
-// modified by ajh to add the second parameter
 {
 	// build an error message string in case we need it
 	string error_msg(condition_string);
-	error_msg += "\n Should be: space-delimited trials(int > 0) Locus Eccentricity > 0";
-	istringstream iss(condition_string);
-	
-	int nt;
-    double le;
-    double cp;
-	string ts;
-	iss >> nt >> le >> cp >> ts;
-	// do all error checks before last read
-	if(!iss)
-		throw Device_exception(this, string("Incorrect condition string: ") + error_msg);
-	if(nt <= 0)
-		throw Device_exception(this, string("Number of trials must be positive ") + error_msg);
-    if (le < 0)
-        throw Device_exception(this, string("Locus width must be positive ") + error_msg);
-    if (cp < 0)
-        throw Device_exception(this, string("Cue proximity must be positive ") + error_msg);
-	
-	//assign parameters
-	if (tagstr != "") tagstr = ts;
-	n_trials = nt;
-    locus_eccentricity = le / 2;
-    cue_proximity = cp;
+	error_msg += "\n Should be: key=value pairs (e.g. n_trials=200 locus_eccentricity=4.15 seed=7),";
+	error_msg += "\n optionally after the positional fields: trials(int > 0) locus_width cue_proximity [tag]";
+
+	try {
+		params.parse(condition_string, variant_defaults);
+	}
+	catch(Parameter_error& x) {
+		throw Device_exception(this, string("Incorrect condition string: ") + x.what() + "\n" + error_msg);
+	}
+
+	double weights[] = {params.spatiotopic_weight, params.retinotopic_weight, params.intermediate_weight};
+	trial_type_table = Alias_table(vector<double>(weights, weights + n_trial_types_c));
+	params.build_delay_sampler(delay_sampler);
+	cell_vrt.configure(n_trial_types_c, delay_sampler.get_bin_starts(params.probe_delay_bin));
+	run_id = params.run_id ? params.run_id : 1;
 }
 
 void simple_device::set_parameter_string(const string& condition_string_)
 {
 	condition_string = condition_string_;
 	parse_condition_string();
+	needs_setup = true;
 }
 
 string simple_device::get_parameter_string() const
@@ -104,13 +133,9 @@ string simple_device::get_parameter_string() const
 	return condition_string;
 }
 
+// one-time setup for the current parameters; per-run state is handled by reset_run()
 void simple_device::initialize()
 {
-	vresponse_made = false;
-	trial = 0;
-	state = START;
-	current_vrt.reset();
-		
     //fill stimulus vector
     vstims.clear();
     vstims.push_back(Blue_c);
@@ -126,87 +151,342 @@ void simple_device::initialize()
 		device_out << "******************************************" << endl;
 		device_out << "Initializeing Device: Retinotopic Attention Task v0.1" << endl;
 		device_out << "Conditions: " << condition_string << endl;
+		device_out << params.describe();
 		device_out << "******************************************" << endl;
 	
 		device_out << "**********************************************************************" << endl;
 		device_out << " trial start" << endl;
-		device_out << " Initial Fixation (500ms)" << endl;
-        device_out << " Memory Cue (200ms)" << endl;
-        device_out << " Post-cue Fixation (500ms)" << endl;
-        device_out << " Initial Fixation (500ms)" << endl;
-        device_out << " Saccadic Fixation (250ms)" << endl;
-        device_out << " Probe Delay (50-400ms)" << endl;
+		device_out << " Initial Fixation (" << params.fixation_duration << "ms)" << endl;
+        device_out << " Memory Cue (" << params.cue_duration << "ms)" << endl;
+        device_out << " Post-cue Fixation (" << params.post_cue_duration << "ms)" << endl;
+        device_out << " Saccade Target (until eye movement lands)" << endl;
+        device_out << " Probe Delay (see Probe Delays above)" << endl;
         
 		device_out << " Probe (Red,Green,Blue, or Yellow) circle, " << endl;
 		device_out << " {button press --> F or J}" << endl;
-		device_out << " Cleanup For Next Trial (ITI = 5000ms)" << endl;
+		device_out << " Cleanup For Next Trial (ITI = " << params.intertrial_interval << "ms)" << endl;
 		device_out << "";
 		device_out << " Conditions" << endl;
 		device_out << " ----------" << endl;
         device_out << " Locus Eccentricity : Controls the distance of attention loci from 0,0 in DVA" << endl;
 		device_out << " ----------" << endl;
-		device_out << " [note, now a 4th parameter that can be any string, write it to output with data.]" << endl;
+		device_out << " Cue Proximity : Offset of the memory cue from the initial fixation in DVA" << endl;
+		device_out << " Tag : any string, written to output with the data" << endl;
 		device_out << "**********************************************************************" << endl;
 	}
 	
-	DataOutputString.str("");
-	
 	// If the streams were open, close.
-	// This is just incase the model is re-initialized.
+	// This is just incase the model is re-initialized with new parameters.
 	if(dataoutput_stream.is_open())
 	{
 		dataoutput_stream.close();
 	}	
+	if(summary_stream.is_open())
+	{
+		summary_stream.close();
+	}	
+	if(bootstrap_stream.is_open())
+	{
+		bootstrap_stream.close();
+	}	
+	if(timing_stream.is_open())
+	{
+		timing_stream.close();
+	}	
 	
-	// open the data output stream for overwriting!
-	openOutputFile(dataoutput_stream, string("data_output"));
-	reparse_conditionstring = false;
+	// open the data output stream for appending
+	if(params.output_mode == Task_parameters::OUTPUT_CSV) {
+		string shard_prefix = (params.shard >= 0) ? shardHeader : string();
+		openOutputFile(dataoutput_stream, params.shard_file(params.output_file), data_header());
+		if(params.summary)
+			openOutputFile(summary_stream, params.shard_file(params.summary_file),
+				shard_prefix + summaryHeader + Trial_summary::csv_header());
+		if(params.bootstrap > 0)
+			openOutputFile(bootstrap_stream, params.shard_file(params.bootstrap_file),
+				shard_prefix + summaryHeader + Bootstrap_engine::csv_header());
+		if(params.timing) {
+			string header = shard_prefix + summaryHeader + timingHeader;
+			for(int i = 0; i < Trial_timing::n_points_c; i++)
+				header += "," + timing_point_names_c[i];
+			openOutputFile(timing_stream, params.shard_file(params.timing_file), header);
+		}
+	}
+	trial_records.reserve(params.n_trials);
+	event_trace.set_capacity(params.trace_size);
+	display.reserve(4 + n_trial_types_c - 1);
+	needs_setup = false;
+	
+	start_new_run(run_seed_for(run_id));
+}
+
+void simple_device::reset_run()
+{
+	reset_run(run_seed_for(run_id));
+}
+
+void simple_device::reset_run(unsigned long seed)
+{
+	if (state != START && state != SHUTDOWN)
+		throw Device_exception(this, "reset_run called while a run is in progress");
+	start_new_run(seed);
+}
+
+// per-run reset without the state check, for the device's own use at setup and after a Stop
+void simple_device::start_new_run(unsigned long seed)
+{
+	vresponse_made = false;
+	trial = 0;
+	state = START;
+	current_vrt.reset();
+	cell_vrt.reset();
+	stale_deadlines.clear();
+	DataOutputString.str("");
+	trial_records.clear();
+	seed_rng(seed);
+}
+
+// seed 0 means draw one from the system entropy source
+void simple_device::seed_rng(unsigned long seed)
+{
+	run_seed = seed;
+	if(run_seed == 0) {
+		std::random_device rd;
+		run_seed = rd();
+	}
+	rng.seed(static_cast<std::mt19937::result_type>(run_seed));
+}
+
+long simple_device::now()
+{
+	return observer ? observer->get_time() : get_time();
+}
+
+void simple_device::schedule_delay(long delay)
+{
+	trace_event(Event_trace::SCHEDULE_DELAY, delay);
+	if (recorder)
+		*recorder << now() << " delay " << delay << "\n";
+	if (observer)
+		observer->schedule_delay(delay);
+	else
+		schedule_delay_event(delay);
+}
+
+void simple_device::present_object(const Symbol& name, GU::Point location, GU::Size size, int label)
+{
+	trace_event(Event_trace::APPEAR, 0, label);
+	if (recorder)
+		*recorder << now() << " appear " << name << " " << location.x << " " << location.y
+			<< " " << size.h << " " << size.v << "\n";
+	if (!observer)
+		make_visual_object_appear(name, location, size);
+}
+
+void simple_device::set_object_property(const Symbol& name, const Symbol& property, const Symbol& value, int label)
+{
+	trace_event(Event_trace::PROPERTY, 0, label, property_label(property));
+	if (recorder)
+		*recorder << now() << " property " << name << " " << property << " " << value << "\n";
+	if (!observer)
+		set_visual_object_property(name, property, value);
+}
+
+void simple_device::remove_object(const Symbol& name, int label)
+{
+	trace_event(Event_trace::DISAPPEAR, 0, label);
+	if (recorder)
+		*recorder << now() << " disappear " << name << "\n";
+	if (!observer)
+		make_visual_object_disappear(name);
+}
+
+void simple_device::stop_run()
+{
+	trace_event(Event_trace::STOP_RUN);
+	if (recorder)
+		*recorder << now() << " stop\n";
+	if (observer)
+		observer->stop();
+	else
+		stop_simulation();
+}
+
+void simple_device::trace_event(Event_trace::Kind_e kind, long value, int object, int detail)
+{
+	event_trace.record(kind, now(), state, value, object, detail);
+}
+
+void simple_device::trace_state_change(State_e previous)
+{
+	if (state != previous)
+		trace_event(Event_trace::STATE_CHANGE, previous);
+}
+
+int simple_device::property_label(const Symbol& property) const
+{
+	if (property == Shape_c) return SHAPE_LABEL;
+	if (property == Color_c) return COLOR_LABEL;
+	if (property == Orientation_c) return ORIENTATION_LABEL;
+	return Event_trace::none_c;
+}
+
+// every handler goes through here: record the call and any state change, and if
+// the body throws - whatever it throws - keep the trace file for the post-mortem
+// before letting the exception go on unchanged
+template <typename... Params, typename... Args>
+void simple_device::run_handler(Event_trace::Kind_e kind, long value, void (simple_device::*body)(Params...),
+	Args&&... args)
+{
+	State_e previous = state;
+	trace_event(kind, value);
+	try {
+		(this->*body)(std::forward<Args>(args)...);
+	}
+	catch(...) {
+		dump_trace_after_error();
+		throw;
+	}
+	trace_state_change(previous);
+}
+
+void simple_device::dump_trace_after_error()
+{
+	if (event_trace.get_capacity() == 0)
+		return;
+	trace_event(Event_trace::EXCEPTION);
+	string filename = params.shard_file(params.trace_file) + ".trace";
+	if (event_trace.dump(filename))
+		show_message("Device error: event trace written to " + filename, true);
+	else
+		show_message("Device error: could not write event trace " + filename, true);
+}
+
+// whether show_message would write anywhere, so callers can skip formatting
+bool simple_device::messages_enabled() const
+{
+	return (get_trace() && Trace_out) || device_out;
+}
+
+// uniform draw from 0 .. n - 1
+int simple_device::random_index(int n)
+{
+	return static_cast<int>(random_below(rng, static_cast<uint32_t>(n)));
+}
+
+// show n display objects from first on: all the appearances, then one pass over each property column
+void simple_device::present_objects(int first, int n)
+{
+	int last = first + n;
+	for (int i = first; i < last; i++) {
+		present_object(display.get_name(i), display.get_location(i), display.get_size(i), display.get_kind(i));
+		display.set_visible(i, true);
+	}
+	for (int i = first; i < last; i++)
+		set_object_property(display.get_name(i), Shape_c, display.get_shape(i), display.get_kind(i));
+	for (int i = first; i < last; i++)
+		set_object_property(display.get_name(i), Color_c, display.get_color(i), display.get_kind(i));
+	for (int i = first; i < last; i++)
+		if (display.has_orientation(i))
+			set_object_property(display.get_name(i), Orientation_c, display.get_orientation(i), display.get_kind(i));
+}
+
+void simple_device::remove_objects(int first, int n)
+{
+	for (int i = first; i < first + n; i++) {
+		if (!display.is_visible(i))
+			continue;
+		remove_object(display.get_name(i), display.get_kind(i));
+		display.set_visible(i, false);
+	}
 }
 
 // You have to get the ball rolling with a first time-delayed event - nothing happens until you do.
 // DK
 void simple_device::handle_Start_event()
+{
+	run_handler(Event_trace::HANDLE_START, 0, &simple_device::begin_run);
+}
+
+void simple_device::begin_run()
 {
 	//	if(device_out)
 	//		device_out << processor_info() << "received Start_event" << endl;
 
+	//only occurs if the parameters were changed since the last run
+	if (needs_setup)
+		initialize();
+
+	metrics.reset();
+	metrics.set_running(true);
+	metrics.count_event(now());
+	update_status_file();
+
 	//determine rule file name so that it can be added to data output. 
-	prsfilenameonly = "";
-	device_out << "@@RuleFile[Full]: " << prsfilename << endl;
-	clear_prspathvector();	//clear out prspathvector
-	prspathvector = split(prsfilename, '/'); //fill prspathvector with the rule file path
-	if (prspathvector.size() > 0) { 
-		prsfilenameonly = prspathvector[prspathvector.size() - 1];
-	}
-	else {
-		prsfilenameonly = "?????.prs";
+	if (prsfilenameonly.empty() || prsfilename != prsfilenamefull) {
+		prsfilenamefull = prsfilename;
+		clear_prspathvector();	//clear out prspathvector
+		prspathvector = split(prsfilename, '/'); //fill prspathvector with the rule file path
+		if (prspathvector.size() > 0) { 
+			prsfilenameonly = prspathvector[prspathvector.size() - 1];
+		}
+		else {
+			prsfilenameonly = "?????.prs";
+		}
 	}
+	device_out << "@@RuleFile[Full]: " << prsfilename << endl;
 	device_out << "@@RuleFile[NameOnly]: " << prsfilenameonly << endl;
 	
 	if(device_out) {
+		device_out << "Seed used: " << run_seed << endl;
 		device_out << "******************{{{{{{{{{{{{{{{{__SIMULATION_START__}}}}}}}}}}}}}}}}***************************" << endl;
 		device_out << "******************{{{{{{{{{{{{{{{{__SIMULATION_START__}}}}}}}}}}}}}}}}***************************" << endl;
 	}
 	
- 	schedule_delay_event(500);
+ 	schedule_delay(params.start_delay);
 }
 
 //called after the stop_simulation function (which is bart of the base device class)
 void simple_device::handle_Stop_event()
+{
+	run_handler(Event_trace::HANDLE_STOP, 0, &simple_device::end_run);
+}
+
+void simple_device::end_run()
 {
 	//	if(device_out)
 	//		device_out << processor_info() << "received Stop_event" << endl;
 	
+	metrics.count_event(now());
+	metrics.set_running(false);
+	update_status_file();
+
 	//show final stats. 	
 	output_statistics();
+	output_summary();
+	output_bootstrap();
+	output_timing();
 	
-	refresh_experiment();
-	
-	//close data output file
+	//keep the data files open for the next run, but make this run's data visible now
 	if(dataoutput_stream.is_open())
 	{
-		dataoutput_stream.close();
+		dataoutput_stream.flush();
+	}		
+	if(summary_stream.is_open())
+	{
+		summary_stream.flush();
+	}		
+	if(bootstrap_stream.is_open())
+	{
+		bootstrap_stream.flush();
+	}		
+	if(timing_stream.is_open())
+	{
+		timing_stream.flush();
 	}		
+	
+	//ready for a restart without any setup; the next run gets the next id, and its own seed
+	run_id++;
+	start_new_run(run_seed_for(run_id));
 }
 
 // STATES: {START, START_TRIAL, PRESENT_CUE, REMOVE_CUE, REMOVE_FIXATION, WAIT_FOR_FIXATION, PRESENT_PROBE, WAITING_FOR_RESPONSE, DISCARD_PROBE, SHUTDOWN}
@@ -214,45 +494,73 @@ void simple_device::handle_Stop_event()
 void simple_device::handle_Delay_event(const Symbol& type, const Symbol& datum, 
 		const Symbol& object_name, const Symbol& property_name, const Symbol& property_value)
 {	
+	run_handler(Event_trace::HANDLE_DELAY, 0, &simple_device::advance_state);
+}
+
+void simple_device::advance_state()
+{
+	metrics.count_event(now());
+
+	// a saccade timeout still pending after the eye landed is stale - swallow it.
+	// With a long timeout it comes due in a later trial, after that trial has set
+	// its own deadline, so each one is matched on its own due time. Delay events
+	// carry no data, so consuming any one event due at that time is equivalent.
+	if (!stale_deadlines.empty() && now() == stale_deadlines.front()) {
+		stale_deadlines.pop_front();
+		return;
+	}
+
 	switch(state) {
 		case START:
 			if (show_states) show_message("********-->STATE: START",true);
 			state = START_TRIAL;
-			schedule_delay_event(500);
+			schedule_delay(params.start_delay);
 			break;
 		case START_TRIAL:
 			if (show_states) show_message("********-->STATE: START_TRIAL",true);
 			vresponse_made = false;
 			start_trial();
 			state = PRESENT_CUE;
-			schedule_delay_event(500);
+			schedule_delay(params.fixation_duration);
 			break;
         case PRESENT_CUE:
             if (show_states) show_message("********-->STATE: PRESENT_CUE",true);
             present_cue();
             state = REMOVE_CUE;
-            schedule_delay_event(200);
+            schedule_delay(params.cue_duration);
             break;
 		case REMOVE_CUE:
 			if (show_states) show_message("********-->STATE: REMOVE_CUE",true);
 			remove_cue();
 			state = REMOVE_FIXATION;
-			schedule_delay_event(500);
+			schedule_delay(params.post_cue_duration);
 			break;
 		case REMOVE_FIXATION:
 			if (show_states) show_message("********-->STATE: REMOVE_FIXATION",true);
+			if (!params.saccade) {
+				hold_fixation();
+				break;
+			}
 			remove_fixation();
             present_saccade_target();
 			state = WAITFOR_EYEMOVE;
+			if (params.saccade_timeout > 0) {
+				saccade_deadline = now() + params.saccade_timeout;
+				schedule_delay(params.saccade_timeout);
+			}
 			break;
         case WAITFOR_EYEMOVE:
             if (show_states) show_message("********-->STATE: WAITFOR_EYEMOVE",true);
-			//nothing to do, just wait
-			//**note: next state and schedule_delay set by response handler
+			//only a saccade timeout gets here; otherwise the eye movement handler sets the next state
+			if (params.saccade_timeout > 0)
+				abandon_trial();
 			break;
         case PRESENT_PROBE:
             if (show_states) show_message("********-->STATE: PRESENT_PROBE",true);
-            remove_saccade_target();
+            if (params.saccade)
+                remove_saccade_target();
+            else
+                remove_fixation();
             present_probe();
             state = WAITING_FOR_RESPONSE;
             break;
@@ -269,7 +577,7 @@ void simple_device::handle_Delay_event(const Symbol& type, const Symbol& datum,
 		case SHUTDOWN:
 			if (show_states) show_message("********-->STATE: SHUTDOWN",true);
 			//Detected Signal to Stop Simulation.
-			stop_simulation();
+			stop_run();
 			break;
 		default:
 			throw Device_exception(this, "Device delay event in unknown or improper device state");
@@ -280,142 +588,164 @@ void simple_device::handle_Delay_event(const Symbol& type, const Symbol& datum,
 //At Trial Start, Warning Stimuli are presented
 void simple_device::start_trial()
 {
-	if (show_debug) show_message("*trial_start|");
-	
-	//only occurs if task is stopped and restarted
-	if (reparse_conditionstring == true) {
-		parse_condition_string(); 
-		initialize();
-	}
+	if (params.show_debug) show_message("*trial_start|");
 	
 	trial++; //increment trial counter
+	metrics.count_trial_start();
+	trace_event(Event_trace::TRIAL_START, trial);
+	timing.start(now());
+	display.clear();
+	name_trial_objects();
 	
 	present_fixation();
 	
-	if (show_debug) show_message("trial_start*", true);
+	if (params.show_debug) show_message("trial_start*", true);
+}
+
+// object names are built once per trial number and kept for later runs
+void simple_device::name_trial_objects()
+{
+	while (static_cast<int>(trial_names.size()) < trial) {
+		int n = static_cast<int>(trial_names.size()) + 1;
+		Trial_names names;
+		names.init_fix = concatenate_to_Symbol(iFix_c, n);
+		names.cue = concatenate_to_Symbol(VCue_c, n);
+		names.sacc_fix = concatenate_to_Symbol(sFix_c, n);
+		names.probe = concatenate_to_Symbol(VProbe_c, n);
+		for (int i = 1; i < n_trial_types_c; i++) {
+			ostringstream distractor;
+			distractor << Distractor_c << n << "_" << i;
+			names.distractors.push_back(Symbol(distractor.str()));
+		}
+		trial_names.push_back(names);
+	}
+	const Trial_names& names = trial_names[trial - 1];
+	init_fix_name = names.init_fix;
+	cue_name = names.cue;
+	sacc_fix_name = names.sacc_fix;
+	vstim_name = names.probe;
 }
 
 void simple_device::present_fixation() {
-    if (show_debug) show_message("*present_fixation|");
+    if (params.show_debug) show_message("*present_fixation|");
     
-    int select_region = rand() % 4;
+    int select_region = random_index(4);
     double fix_x;
     double fix_y;
     
     switch (select_region) {
         case 0:
-            fix_x = -1 * locus_eccentricity;
-            fix_y = -1 * locus_eccentricity;
+            fix_x = -1 * params.locus_eccentricity;
+            fix_y = -1 * params.locus_eccentricity;
             break;
         case 1:
-            fix_x = locus_eccentricity;
-            fix_y = -1 * locus_eccentricity;
+            fix_x = params.locus_eccentricity;
+            fix_y = -1 * params.locus_eccentricity;
             break;
         case 2:
-            fix_x = -1 * locus_eccentricity;
-            fix_y = locus_eccentricity;
+            fix_x = -1 * params.locus_eccentricity;
+            fix_y = params.locus_eccentricity;
             break;
         default:
-            fix_x = locus_eccentricity;
-            fix_y = locus_eccentricity;
+            fix_x = params.locus_eccentricity;
+            fix_y = params.locus_eccentricity;
             break;
     }
     
-    init_fix_name = concatenate_to_Symbol(iFix_c, trial);
     init_fix_location = GU::Point(fix_x,fix_y);
     
-    make_visual_object_appear(init_fix_name, init_fix_location, wstim_size_c);
-	set_visual_object_property(init_fix_name, Shape_c, Empty_Circle_c);
-    set_visual_object_property(init_fix_name, Color_c, Gray_c);
+    init_fix_object = display.add(init_fix_name, init_fix_location, wstim_size_c, Empty_Circle_c, Gray_c,
+        Symbol(), INIT_FIXATION_LABEL);
+    present_objects(init_fix_object);
     
-	//vstim_onset = get_time();  //MOVE ME
+	//vstim_onset = now();  //MOVE ME
     
-    if (show_debug) show_message("present_fixation*", true);
+    if (params.show_debug) show_message("present_fixation*", true);
 }
 
 void simple_device::present_cue()
 {
 	
-	if (show_debug) show_message("*present_cue|");
+	if (params.show_debug) show_message("*present_cue|");
     
-    int select_region = rand() % 4;
+    int select_region = random_index(4);
     double cue_x;
     double cue_y;
     
     switch (select_region) {
         case 0:
-            cue_x = -1 * cue_proximity + init_fix_location.x;
-            cue_y = -1 * cue_proximity + init_fix_location.y;
+            cue_x = -1 * params.cue_proximity + init_fix_location.x;
+            cue_y = -1 * params.cue_proximity + init_fix_location.y;
             break;
         case 1:
-            cue_x = cue_proximity + init_fix_location.x;
-            cue_y = -1 * cue_proximity + init_fix_location.y;
+            cue_x = params.cue_proximity + init_fix_location.x;
+            cue_y = -1 * params.cue_proximity + init_fix_location.y;
             break;
         case 2:
-            cue_x = -1 * cue_proximity + init_fix_location.x;
-            cue_y = cue_proximity + init_fix_location.y;
+            cue_x = -1 * params.cue_proximity + init_fix_location.x;
+            cue_y = params.cue_proximity + init_fix_location.y;
             break;
         default:
-            cue_x = cue_proximity + init_fix_location.x;
-            cue_y = cue_proximity + init_fix_location.y;
+            cue_x = params.cue_proximity + init_fix_location.x;
+            cue_y = params.cue_proximity + init_fix_location.y;
             break;
     }
     
     cue_location = GU::Point(cue_x, cue_y);
 	
 	//display visual fixation piont 
-	cue_name = concatenate_to_Symbol(VCue_c, trial);
-	make_visual_object_appear(cue_name, cue_location, wstim_size_c);
-	set_visual_object_property(cue_name, Shape_c, Empty_Square_c);
-    set_visual_object_property(cue_name, Color_c, Black_c);
+	cue_object = display.add(cue_name, cue_location, wstim_size_c, Empty_Square_c, Black_c, Symbol(), CUE_LABEL);
+	present_objects(cue_object);
+    timing.mark(Trial_timing::CUE_ON, now());
 	
-	if (show_debug) show_message("present_cue*", true);
+	if (params.show_debug) show_message("present_cue*", true);
 }
 
 void simple_device::remove_cue()
 {
-	if (show_debug) show_message("*remove_cue|");
+	if (params.show_debug) show_message("*remove_cue|");
 	
 	// remove the warningstimulus
-	make_visual_object_disappear(cue_name);
+	remove_objects(cue_object);
+	timing.mark(Trial_timing::CUE_OFF, now());
 	
-	if (show_debug) show_message("remove_cue*", true);
+	if (params.show_debug) show_message("remove_cue*", true);
 }
 
 void simple_device::remove_fixation()
 {
-	if (show_debug) show_message("*removing_fixation|");
+	if (params.show_debug) show_message("*removing_fixation|");
 	
 	// remove the stimulus
-	make_visual_object_disappear(init_fix_name);
+	remove_objects(init_fix_object);
+	timing.mark(Trial_timing::FIXATION_OFF, now());
 	
-	setup_next_trial();
-	if (show_debug) show_message("....removing_fixation*");
+	if (params.show_debug) show_message("....removing_fixation*");
 }
 
 void simple_device::present_saccade_target() {
-    if (show_debug) show_message("*present_saccade_fixation|");
+    if (params.show_debug) show_message("*present_saccade_fixation|");
     
-    int select_region = rand() % 4;
+    int select_region = random_index(4);
     double fix_x;
     double fix_y;
     
     switch (select_region) {
         case 0:
-            fix_x = -1 * locus_eccentricity;
-            fix_y = -1 * locus_eccentricity;
+            fix_x = -1 * params.locus_eccentricity;
+            fix_y = -1 * params.locus_eccentricity;
             break;
         case 1:
-            fix_x = locus_eccentricity;
-            fix_y = -1 * locus_eccentricity;
+            fix_x = params.locus_eccentricity;
+            fix_y = -1 * params.locus_eccentricity;
             break;
         case 2:
-            fix_x = -1 * locus_eccentricity;
-            fix_y = locus_eccentricity;
+            fix_x = -1 * params.locus_eccentricity;
+            fix_y = params.locus_eccentricity;
             break;
         default:
-            fix_x = locus_eccentricity;
-            fix_y = locus_eccentricity;
+            fix_x = params.locus_eccentricity;
+            fix_y = params.locus_eccentricity;
             break;
     }
     
@@ -428,42 +758,64 @@ void simple_device::present_saccade_target() {
         fix_y = fix_y * -1;
     }
     
-    sacc_fix_name = concatenate_to_Symbol(sFix_c, trial);
     sacc_fix_location = GU::Point(fix_x,fix_y);
     
-    make_visual_object_appear(sacc_fix_name, sacc_fix_location, wstim_size_c);
-	set_visual_object_property(sacc_fix_name, Shape_c, Empty_Circle_c);
-    set_visual_object_property(sacc_fix_name, Color_c, Gray_c);
+    sacc_fix_object = display.add(sacc_fix_name, sacc_fix_location, wstim_size_c, Empty_Circle_c, Gray_c,
+        Symbol(), SACCADE_FIXATION_LABEL);
+    present_objects(sacc_fix_object);
+    
+    starget_onset = now();
+    timing.mark(Trial_timing::TARGET_ON, starget_onset);
+    if (observer) observer->saccade_target_presented(sacc_fix_location);
     
-    starget_onset = get_time();
+    if (params.show_debug) show_message("present_saccade_fixation*", true);
+}
 
+// no-saccade control: the initial fixation stands in for the saccade target,
+// so all probe locations collapse onto the cue, and the probe delay runs from now
+void simple_device::hold_fixation() {
+    if (params.show_debug) show_message("*hold_fixation|");
+    
+    sacc_fix_location = init_fix_location;
+    starget_onset = now();
+    saccade_duration = 0;
+    probe_delay = delay_sampler.sample(rng);
+    state = PRESENT_PROBE;
+    schedule_delay(probe_delay);
     
-    if (show_debug) show_message("present_saccade_fixation*", true);
+    if (params.show_debug) show_message("hold_fixation*", true);
+}
+
+// the start of the saccade that finally lands on the target is the one kept
+void simple_device::handle_Eyemovement_Start_event(const Symbol& target_name, GU::Point new_location) {
+    run_handler(Event_trace::HANDLE_EYEMOVE_START, 0, &simple_device::process_eye_start, new_location);
+}
+
+void simple_device::process_eye_start(GU::Point new_location) {
+    metrics.count_event(now());
+    if (state == WAITFOR_EYEMOVE)
+        timing.mark(Trial_timing::SACCADE_START, now());
 }
 
 void simple_device::handle_Eyemovement_End_event(const Symbol& target_name, GU::Point new_location) {
-    if (show_debug) show_message("*handle_Eyemovement_End_event....",true);
+    run_handler(Event_trace::HANDLE_EYEMOVE_END, 0, &simple_device::process_eye_landing, new_location);
+}
+
+void simple_device::process_eye_landing(GU::Point new_location) {
+    if (params.show_debug) show_message("*handle_Eyemovement_End_event....",true);
+    metrics.count_event(now());
     
     if (state == WAITFOR_EYEMOVE && new_location == sacc_fix_location) {
         
         state = PRESENT_PROBE;
-        saccade_duration = get_time() - starget_onset;
-        
-        int select_delay = rand() % 3;
+        if (params.saccade_timeout > 0)
+            stale_deadlines.push_back(saccade_deadline);
+        saccade_duration = now() - starget_onset;
+        timing.mark(Trial_timing::SACCADE_END, now());
         
-        switch (select_delay) {
-            case 0:
-                probe_delay = 50;
-                break;
-            case 1:
-                probe_delay = 250;
-                break;
-            default:
-                probe_delay = 400;
-                break;
-        }
+        probe_delay = delay_sampler.sample(rng);
         
-        schedule_delay_event(probe_delay);
+        schedule_delay(probe_delay);
     }
 }
 
@@ -476,63 +828,79 @@ void simple_device::present_probe()
 
 void simple_device::make_vis_stim_appear()
 {
-    double probe_x;
-    double probe_y;
-    
-	if (show_debug) show_message("*make_vis_stim_appear|");
-	int stim_index = rand() % 2;				// chooses one of the vstims to display
+	if (params.show_debug) show_message("*make_vis_stim_appear|");
+	int stim_index = random_index(2);				// chooses one of the vstims to display
     
 	vstim_color = vstims.at(stim_index);
     probe_orientation = (stim_index == 0) ? -45 : 45;
 	correct_vresp = (stim_index == 0) ? vresps.at(0) : vresps.at(1); //fixme: response mapping
-	vstim_name = concatenate_to_Symbol(VProbe_c, trial);
     
-    int select_trial_type = rand() % 3;
-    //select_trial_type = 2;
-    switch (select_trial_type) {
-        case 0:
-            probe_location = cue_location;
-            trial_type = spatiotopic_c;
-            break;
-        case 1:
-            probe_x = sacc_fix_location.x + (cue_location.x - init_fix_location.x);
-            probe_y = sacc_fix_location.y + (cue_location.y - init_fix_location.y);
-            
-            probe_location = GU::Point(probe_x, probe_y);
-            trial_type = retinotopic_c;
-            break;
-        default:
-            probe_x = ((sacc_fix_location.x - init_fix_location.x) / 2)  + cue_location.x;
-            probe_y = ((sacc_fix_location.y - init_fix_location.y) / 2) + cue_location.y;
-            
-            probe_location = GU::Point(probe_x, probe_y);
-            trial_type = intermediate_c;
-            break;
-    }
+    // candidate probe locations, in trial type order
+    GU::Point candidates[n_trial_types_c];
+    candidates[0] = cue_location;
+    candidates[1] = GU::Point(sacc_fix_location.x + (cue_location.x - init_fix_location.x),
+        sacc_fix_location.y + (cue_location.y - init_fix_location.y));
+    candidates[2] = GU::Point(((sacc_fix_location.x - init_fix_location.x) / 2) + cue_location.x,
+        ((sacc_fix_location.y - init_fix_location.y) / 2) + cue_location.y);
+    
+    trial_type_index = trial_type_table.sample(rng);
+    probe_location = candidates[trial_type_index];
+    trial_type = trial_types_c[trial_type_index];
+	
+	probe_object = display.add(vstim_name, probe_location, vstim_size_c, Line_c, vstim_color,
+		probe_orientation, PROBE_LABEL);
+	n_probe_objects = 1;
 	
-	make_visual_object_appear(vstim_name, probe_location, vstim_size_c);
-	set_visual_object_property(vstim_name, Shape_c, Line_c);
-    set_visual_object_property(vstim_name, Color_c, vstim_color);
-    set_visual_object_property(vstim_name, Orientation_c, probe_orientation);
+	// green distractors (never a response color) go to the other candidate locations
+	// not already taken (in the no-saccade control they all coincide with the probe)
+	if (params.probe_distractors) {
+		const std::vector<Symbol>& distractor_names = trial_names[trial - 1].distractors;
+		for (int type = 0; type < n_trial_types_c; type++) {
+			bool taken = false;
+			for (int i = probe_object; i < probe_object + n_probe_objects; i++)
+				taken = taken || display.get_location(i) == candidates[type];
+			if (taken)
+				continue;
+			int orientation = (random_index(2) == 0) ? -45 : 45;
+			display.add(distractor_names[n_probe_objects - 1], candidates[type], vstim_size_c, Line_c,
+				Green_c, orientation, DISTRACTOR_LABEL);
+			n_probe_objects++;
+		}
+	}
+	present_objects(probe_object, n_probe_objects);
 	 
-	vstim_onset = get_time();
+	vstim_onset = now();
+	timing.mark(Trial_timing::PROBE_ON, vstim_onset);
 	vresponse_made = false;
-	if (show_debug) show_message("make_vis_stim_appear*", true);
+	if (observer) observer->probe_presented(trial_type_index, probe_delay, correct_vresp, vresps.at(1 - stim_index));
+	if (params.show_debug) show_message("make_vis_stim_appear*", true);
 }
 
 
 // here if a keystroke event is received
 void simple_device::handle_Keystroke_event(const Symbol& key_name)
 {
-	if (show_debug) show_message("*handle_Keystroke_event....",true);
+	long key_index = find(vresps.begin(), vresps.end(), key_name) - vresps.begin();
+	run_handler(Event_trace::HANDLE_KEYSTROKE, (key_index < long(vresps.size())) ? key_index : -1,
+		&simple_device::process_keystroke, key_name);
+}
+
+void simple_device::process_keystroke(const Symbol& key_name)
+{
+	if (params.show_debug) show_message("*handle_Keystroke_event....",true);
+	metrics.count_event(now());
 	//ostringstream outputString;  //defined in simple_device.h (tls)
 	outputString.str("");
     std::string isCorrect;
-    long rt = get_time() - vstim_onset;
+    long rt = now() - vstim_onset;
+    timing.mark(Trial_timing::KEYSTROKE, now());
 	
 	if(key_name == correct_vresp) {
         isCorrect = "CORRECT";
-		if(trial > 1) current_vrt.update(rt);
+		if(trial >= Trial_record::first_analyzed_trial_c) {
+			current_vrt.update(rt);
+			cell_vrt.update(trial_type_index, probe_delay, rt);
+		}
 	}
 	else {
         isCorrect = "INCORRECT";
@@ -540,103 +908,149 @@ void simple_device::handle_Keystroke_event(const Symbol& key_name)
 		//if(trial > 1) current_vrt.update(rt); //don't average incorrect responses
 	}
     
-    outputString
-    << "Trial # " << trial
-    << " | (retinotopictask) | RT: " << rt
-    << " | Trial Type: " << trial_type
-    << " | Initial Fixation: (" << init_fix_location.x << "," << init_fix_location.y << ")"
-    << " | Cue Location: (" << cue_location.x << "," << cue_location.y << ")"
-    << " | Saccade Target: (" << sacc_fix_location.x << "," << sacc_fix_location.y << ")"
-    << " | Saccade Duration: " << saccade_duration
-    << " | Probe Location: (" << probe_location.x << "," << probe_location.y << ")"
-    << " | Probe Delay: " << probe_delay
-    << " | Probe Orientation: " << probe_orientation
-    << " | Keystroke: " << key_name
-    << " | CorrectResponse: " << correct_vresp
-    << " | (" << isCorrect << ")" << endl;
+    if (messages_enabled()) {
+        outputString
+        << "Trial # " << trial
+        << " | (retinotopictask) | RT: " << rt
+        << " | Trial Type: " << trial_type
+        << " | Initial Fixation: (" << init_fix_location.x << "," << init_fix_location.y << ")"
+        << " | Cue Location: (" << cue_location.x << "," << cue_location.y << ")"
+        << " | Saccade Target: (" << sacc_fix_location.x << "," << sacc_fix_location.y << ")"
+        << " | Saccade Duration: " << saccade_duration
+        << " | Saccade Latency: " << timing.saccade_latency()
+        << " | Movement Time: " << timing.movement_time()
+        << " | Probe Location: (" << probe_location.x << "," << probe_location.y << ")"
+        << " | Probe Delay: " << probe_delay
+        << " | Probe Orientation: " << probe_orientation
+        << " | Keystroke: " << key_name
+        << " | CorrectResponse: " << correct_vresp
+        << " | (" << isCorrect << ")" << endl;
+        show_message(outputString.str());
+    }
     
-    DataOutputString << "RETINOTOPICTASK" << ","
-    << trial << ","
-    << trial_type << ","
-    << probe_delay << ","
-    << rt << ","
-    << saccade_duration << ","
-    << probe_orientation << ","
-    << key_name << ","
-    << correct_vresp << ","
-    << isCorrect << ","
-    << tagstr << ","
-    << prsfilenameonly << endl;
+    // raw data is only kept if it will be written, shown or recorded
+    if (params.output_mode == Task_parameters::OUTPUT_CSV || messages_enabled() || recorder) {
+        ostringstream row;
+        if (params.shard >= 0)
+            row << params.shard << "," << run_id << "," << run_seed << ",";
+        row << "RETINOTOPICTASK" << ","
+        << trial << ","
+        << trial_type << ","
+        << probe_delay << ","
+        << rt << ","
+        << saccade_duration << ","
+        << probe_orientation << ","
+        << key_name << ","
+        << correct_vresp << ","
+        << isCorrect << ","
+        << params.tag << ","
+        << prsfilenameonly << ","
+        << timing.saccade_latency() << ","
+        << timing.movement_time();
+        trial_data_string = row.str();
+        DataOutputString << trial_data_string << endl;
+        if (recorder)
+            *recorder << now() << " row " << trial_data_string << "\n";
+    }
     
-	show_message(outputString.str());
 	vresponse_made = true;
+	metrics.count_response(key_name == correct_vresp);
 	
-	if (show_debug) show_message("....handle_Keystroke_event*");
+	Trial_record record;
+	record.trial = trial;
+	record.probe_delay = static_cast<int32_t>(probe_delay);
+	record.rt = static_cast<int32_t>(rt);
+	record.saccade_duration = static_cast<int32_t>(saccade_duration);
+	record.trial_type = static_cast<int8_t>(trial_type_index);
+	record.correct = (key_name == correct_vresp);
+	record.timing = timing;
+	trial_records.push_back(record);
+	if (params.status_interval > 0 && trial % params.status_interval == 0)
+		update_status_file();
+	
+	if (params.show_debug) show_message("....handle_Keystroke_event*");
 	
 	state = DISCARD_PROBE;
-	schedule_delay_event(500);
+	schedule_delay(params.probe_linger);
 }
 
 void simple_device::remove_probe()
 {
-	if (show_debug) show_message("*removing_probe|");
+	if (params.show_debug) show_message("*removing_probe|");
 	
 	// remove the stimulus
-	make_visual_object_disappear(vstim_name);
+	remove_objects(probe_object, n_probe_objects);
+	if (!trial_records.empty() && trial_records.back().trial == trial)
+		trial_records.back().timing.mark(Trial_timing::PROBE_OFF, now());
+	
+	setup_next_trial();
+	if (params.show_debug) show_message("....removing_probe*");
+}
+
+// no eye movement within the saccade timeout: clear the display and move on without a response
+void simple_device::abandon_trial()
+{
+	if (params.show_debug) show_message("*abandon_trial|");
+	
+	outputString.str("");
+	outputString << "Trial # " << trial << " | (retinotopictask) | Saccade timeout after " << params.saccade_timeout << "ms" << endl;
+	show_message(outputString.str());
 	
+	trace_event(Event_trace::SACCADE_TIMEOUT, params.saccade_timeout);
+	remove_saccade_target();
+	metrics.count_saccade_timeout();
 	setup_next_trial();
-	if (show_debug) show_message("....removing_probe*");
+	if (params.show_debug) show_message("....abandon_trial*");
+}
+
+void simple_device::update_status_file()
+{
+	if (params.status_file.empty())
+		return;
+	if (!metrics.write_status_file(params.status_file))
+		show_message("Error writing status file: " + params.status_file, true);
 }
 
 void simple_device::remove_saccade_target() {
-    if (show_debug) show_message("*removing_saccade_target|");
-    make_visual_object_disappear(sacc_fix_name);
-    if (show_debug) show_message("....removing_saccade_target*");
+    if (params.show_debug) show_message("*removing_saccade_target|");
+    remove_objects(sacc_fix_object);
+    timing.mark(Trial_timing::TARGET_OFF, now());
+    if (params.show_debug) show_message("....removing_saccade_target*");
 }
 
 void simple_device::setup_next_trial()
 {	
 	// set up another trial if the experiment is to continue
-	if(trial < n_trials) {
-		if (show_debug) show_message("*setup_next_trial|");
+	if(trial < params.n_trials) {
+		if (params.show_debug) show_message("*setup_next_trial|");
 		state = START_TRIAL;
-		schedule_delay_event(intertrialinterval_c);
-		if (show_debug) show_message("setup_next_trial*");
+		schedule_delay(params.intertrial_interval);
+		if (params.show_debug) show_message("setup_next_trial*");
 	}
 	else { 
-		if (show_debug) show_message("*shutdown_experiment|");
+		if (params.show_debug) show_message("*shutdown_experiment|");
 		state = SHUTDOWN;
-		schedule_delay_event(500);
-		//stop_simulation();
-		if (show_debug) show_message("shutdown_experiment*");
+		schedule_delay(params.shutdown_delay);
+		//stop_run();
+		if (params.show_debug) show_message("shutdown_experiment*");
 	}
 }
 
-void simple_device::refresh_experiment() {
-	// call this from very last procedure...currently that is output_statistics()
-	
-	vresponse_made = false;
-	trial = 0;
-	state = START;
-	current_vrt.reset();
-	reparse_conditionstring = true;
-}
-
 void simple_device::output_statistics() //const
 {
-	if (show_debug) show_message("*output_statistics|");
+	if (params.show_debug) show_message("*output_statistics|");
 	
 	show_message("*** End of experiment! ***",true);
 
 	// show condition
 	outputString.str("");
-	outputString << "\nCONDITION = ";
+	outputString << "\nCONDITION = " << condition_string;
 	
 	show_message(outputString.str());	
 	
 	// show total trials
 	outputString.str("");
-	outputString << "\nTotal trials = " << '\t' << n_trials << endl;
+	outputString << "\nTotal trials = " << '\t' << params.n_trials << endl;
 	show_message(outputString.str());
 
 	// show performance
@@ -645,23 +1059,92 @@ void simple_device::output_statistics() //const
 			<< ", RT = " << fixed << setprecision(0) << setw(4) << current_vrt.get_mean();
 	show_message(outputString.str(),true);
 	show_message(" ", true);
-	show_message("NOTE: Average Ignores 1st Trial",true);
+
+	// show performance by trial type and probe delay bin
+	outputString.str("");
+	outputString << setw(14) << "TRIAL_TYPE" << setw(12) << "DELAY_BIN" << setw(6) << "N"
+		<< setw(8) << "RT" << setw(8) << "SE" << endl;
+	for(int row = 0; row < cell_vrt.get_n_rows(); row++) {
+		for(int bin = 0; bin < cell_vrt.get_n_bins(); bin++) {
+			const Current_variance& cell = cell_vrt.get_cell(row, bin);
+			if(cell.get_n() == 0)
+				continue;
+			outputString << setw(14) << trial_types_c[row].str() << setw(12) << cell_vrt.get_bin_start(bin)
+				<< setw(6) << cell.get_n() << setw(8) << cell.get_mean() << setw(8) << cell.get_se() << endl;
+		}
+	}
+	show_message(outputString.str(),true);
+	show_message("NOTE: Averages Ignore 1st Trial",true);
 					
 	show_message("*** ****************** ***",true);
-	
-	refresh_experiment();
 
-	if (show_debug) show_message("output_statistics*",true);
+	if (params.show_debug) show_message("output_statistics*",true);
 	
 	show_message("************* RAW DATA ***************");
 	outputString.str("");
-	outputString << dataHeader << endl;
+	outputString << data_header() << endl;
 	show_message(outputString.str());
 	show_message(DataOutputString.str());
 	show_message("**************************************");
 	
 	//Write Collated Raw Data To Output File
-	dataoutput_stream << DataOutputString.str();	
+	if(dataoutput_stream.is_open())
+		dataoutput_stream << DataOutputString.str();	
+}
+
+// the summarySEwithin table of the old R post-processing, one block per run
+void simple_device::output_summary()
+{
+	if (!summary_stream.is_open())
+		return;
+	
+	Trial_summary summary(delay_sampler.get_bin_starts(params.probe_delay_bin), params.winsor);
+	Trial_summary::write_csv(summary_stream, summary.summarize(trial_records), trial_type_names_c, run_prefix());
+}
+
+// percentile bootstrap CIs for the facilitation effects, seeded from the run seed
+void simple_device::output_bootstrap()
+{
+	if (!bootstrap_stream.is_open())
+		return;
+	
+	Bootstrap_engine engine(trial_records, delay_sampler.get_bin_starts(params.probe_delay_bin), params.winsor);
+	Bootstrap_engine::write_csv(bootstrap_stream, engine.run(params.bootstrap, run_seed, params.bootstrap_threads),
+		params.bootstrap, trial_type_names_c, run_prefix());
+}
+
+// one row per trial with a response, written at the end of the run so PROBE_OFF (marked in remove_probe) is in
+void simple_device::output_timing()
+{
+	if (!timing_stream.is_open())
+		return;
+	
+	string prefix = run_prefix();
+	for (vector<Trial_record>::size_type i = 0; i < trial_records.size(); i++) {
+		const Trial_record& r = trial_records[i];
+		timing_stream << prefix << r.trial << "," << trial_type_names_c[r.trial_type] << "," << r.timing.onset;
+		for (int point = 0; point < Trial_timing::n_points_c; point++)
+			timing_stream << "," << r.timing.at[point];
+		timing_stream << '\n';
+	}
+}
+
+// data file columns; sharded rows start with their run's provenance (and no blank line before the header)
+string simple_device::data_header() const
+{
+	if (params.shard < 0)
+		return dataHeader;
+	return shardHeader + "SEED," + dataHeader.substr(dataHeader.find_first_not_of('\n'));
+}
+
+// provenance fields leading each summary and bootstrap row, comma-terminated
+string simple_device::run_prefix() const
+{
+	ostringstream prefix;
+	if (params.shard >= 0)
+		prefix << params.shard << "," << run_id << ",";
+	prefix << params.tag << "," << prsfilenameonly << "," << run_seed << ",";
+	return prefix.str();
 }
 
 void simple_device::show_message(const std::string& thestring, const bool addendl) {
@@ -675,26 +1158,50 @@ void simple_device::show_message(const std::string& thestring, const bool addend
 	}
 }
 
-void simple_device::openOutputFile(ofstream & outFileStream, const string filename_text)
+void simple_device::openOutputFile(ofstream & outFileStream, const string filename_text, const string& header)
 
 {
 	string fileName = filename_text + ".csv";
-	bool filealreadyexists = fexists(fileName.c_str());
+	// appending rows under another version's columns would silently misalign them
+	string existing_header;
+	bool filealreadyexists = read_csv_header(fileName, existing_header);
+	if (filealreadyexists && !existing_header.empty() && existing_header != header.substr(header.find_first_not_of('\n')))
+		throw Device_exception(this, " Output file " + fileName + " has different columns:\n " + existing_header
+			+ "\n Move it aside or choose another file name to write:\n " + header.substr(header.find_first_not_of('\n')));
 	//outFileStream.open((fileName).c_str(), ofstream::out); //overwriting
 	outFileStream.open((fileName).c_str(), ofstream::app); //appending
 	if(!outFileStream.is_open()) {
 		throw Device_exception(this, " Error opening output file: " + fileName);
 		show_message("Error opening output file:" + fileName, true);
 	} 
-	else if (!filealreadyexists) 
-		outFileStream << dataHeader << endl;
+	else if (!filealreadyexists || existing_header.empty()) 
+		outFileStream << header << endl;
 	
 }
 
 bool simple_device::fexists(const char *filename)
 {
 	ifstream ifile(filename);
-	return ifile;
+	return ifile.good();
+}
+
+// false if the file does not exist; header is its first non-blank line, or empty if it has none
+bool simple_device::read_csv_header(const string& filename, string& header)
+{
+	header.clear();
+	ifstream ifile(filename.c_str());
+	if (!ifile.good())
+		return false;
+	string line;
+	while (getline(ifile, line)) {
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+		if (!line.empty()) {
+			header = line;
+			break;
+		}
+	}
+	return true;
 }
 
 //------------------------------------------------------------------------------
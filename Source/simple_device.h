@@ -7,22 +7,33 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <random>
+#include <deque>
 
 #include "EPICLib/Device_base.h"
 #include "EPICLib/Symbol.h"
 #include "EPICLib/Geometry.h"
 #include "Statistics.h"
+#include "Task_parameters.h"
+#include "Delay_sampler.h"
+#include "Run_metrics.h"
+#include "Trial_record.h"
+#include "Event_trace.h"
+#include "Visual_object_pool.h"
 
 namespace GU = Geometry_Utilities;
 using namespace std;
 using std::ostringstream;
 
+class Synthetic_observer;
+
 // see implementation file for conversion functions and constants 
 // pertaining to screen layout
 
 class simple_device : public Device_base {
 public:
-	simple_device(const std::string& id, Output_tee& ot);
+	// variant_parameters presets the defaults that the condition string is parsed over
+	simple_device(const std::string& id, Output_tee& ot, const std::string& variant_parameters = "");
 			
 	virtual void initialize();
 	virtual void set_parameter_string(const std::string&);
@@ -34,15 +45,47 @@ public:
 	virtual void handle_Delay_event(const Symbol& type, const Symbol& datum, 
 		const Symbol& object_name, const Symbol& property_name, const Symbol& property_value);
 	virtual void handle_Keystroke_event(const Symbol& key_name);
+    virtual void handle_Eyemovement_Start_event(const Symbol& target_name, GU::Point new_location);
     virtual void handle_Eyemovement_End_event(const Symbol& target_name, GU::Point new_location);
+
+	// prepare for another run on this instance: resets trial counters, statistics
+	// and the RNG (reseeded with run_seed_for(run id), or with seed if given), but keeps
+	// the parsed parameters, stimulus lists, interned names and the open data file.
+	// Only allowed between runs (state START or SHUTDOWN); throws Device_exception otherwise.
+	void reset_run();
+	void reset_run(unsigned long seed);
+	// a fixed seed= gives run n of the parameters the seed seed + n - 1, so the first
+	// run uses seed itself and back-to-back runs draw different trials; a run's seed
+	// depends only on its id, whichever instance or shard runs it. 0 stays 0 (entropy).
+	unsigned long run_seed_for(long run_id_) const
+		{return params.seed ? params.seed + static_cast<unsigned long>(run_id_ - 1) : 0;}
+
+	// route time, delays and display calls to a Synthetic_observer instead of
+	// the EPIC architecture (0 detaches); see Synthetic_observer::run()
+	void attach_observer(Synthetic_observer* observer_)
+		{observer = observer_;}
+
+	// write every simulation call and data row made by the device to the stream,
+	// one line each with its time stamp (0 detaches); see Golden_harness.h
+	void attach_recorder(std::ostream* recorder_)
+		{recorder = recorder_;}
+
+	// live progress counters; snapshot() may be called from any thread
+	const Run_metrics& get_metrics() const
+		{return metrics;}
+
+	// write the recent handler calls, state changes, delays and display calls
+	// to a binary file (see Event_trace.h); this happens automatically when a
+	// handler throws, whatever the exception. Returns false if it could not be written.
+	bool dump_event_trace(const std::string& filename) const
+		{return event_trace.dump(filename);}
 			
 private:
 	enum State_e {START, START_TRIAL, PRESENT_CUE, REMOVE_CUE, REMOVE_FIXATION, WAITFOR_EYEMOVE, PRESENT_PROBE, WAITING_FOR_RESPONSE, DISCARD_PROBE, SHUTDOWN};
 	State_e state;
     
     Symbol trial_type;
-    double locus_eccentricity;
-    double cue_proximity;
+    int trial_type_index;
     GU::Point init_fix_location;
     GU::Point sacc_fix_location;
     GU::Point cue_location;
@@ -50,9 +93,15 @@ private:
     int probe_orientation;
 	
 	// parameters
-	int n_total_trials;	 //total trials in the run
+	Task_parameters variant_defaults;	//task variant preset, see create_simple_device.cpp
+	Task_parameters params;	//parsed and validated condition string
 	int colorcount = 2; //number of colors to display
-	std::string tagstr; //for any info, defaults to "draft"
+
+	// randomization
+	std::mt19937 rng;
+	unsigned long run_seed;	//seed actually used for this run
+	Alias_table trial_type_table;	//draws TRIAL_TYPE from the trial type weights
+	Delay_sampler delay_sampler;
 	
 	
 	// stimulus and response lists
@@ -76,44 +125,113 @@ private:
 	long probe_delay;			//time of blank between fixation and stim onset
 	
 	Current_mean current_vrt;
+	Cell_statistics cell_vrt;	//correct RTs by trial type x probe delay bin
+	Run_metrics metrics;
+	Event_trace event_trace;		//always-on flight recorder, dumped when a handler throws
+	Synthetic_observer* observer;	//0 when running under EPIC
+	std::ostream* recorder;			//call transcript, 0 when not recording
 	
-	bool reparse_conditionstring; //used for when task is restarted after a halt
+	long saccade_deadline;			//time this trial's saccade timeout fires
+	std::deque<long> stale_deadlines;	//due times of timeouts the eye beat, oldest first
+	
+	bool needs_setup; //no initialize() yet for the current parameters, so do it at the next Start
+	long run_id;		//numbers the runs of this instance; picks the run seed and is written in sharded output
+	
+	// this trial's display, in presentation order, and where each phase's objects are in it
+	Visual_object_pool display;
+	int init_fix_object;
+	int cue_object;
+	int sacc_fix_object;
+	int probe_object;		//the probe, followed by its distractors
+	int n_probe_objects;
+	
+	// per-trial object names, interned once and reused by every run
+	struct Trial_names {
+		Symbol init_fix, cue, sacc_fix, probe;
+		std::vector<Symbol> distractors;
+	};
+	std::vector<Trial_names> trial_names;
 	
 	// data accumulation		
 	std::string condition_string; //holds current condition
-	int n_trials;                 //number of trials run so far
 	long vstim_onset;             //timestamp for visual stimulus onset
     long starget_onset;             //timestamp for saccade target stimulus
     long saccade_duration;
+	Trial_timing timing;			//this trial's display, eye movement and keystroke times
 	std::vector <std::string> prspathvector;
+	std::string prsfilenamefull;	//prsfilename that prsfilenameonly was derived from
 	std::string prsfilenameonly;
 	
 	ostringstream outputString;
 	ostringstream DataOutputString;
 	std::string trial_data_string;
 	std::ofstream dataoutput_stream;				// Output data on every trail	
+	std::ofstream summary_stream;					// summary table at the end of every run
+	std::ofstream bootstrap_stream;					// bootstrap CIs at the end of every run
+	std::ofstream timing_stream;					// trial timing vectors at the end of every run
+	std::vector<Trial_record> trial_records;		// this run's responses, for the summary
 			
+	// all simulation calls go through these so an attached observer can take them
+	long now();
+	void schedule_delay(long delay);
+	// (label is the object's event trace label)
+	void present_object(const Symbol& name, GU::Point location, GU::Size size, int label);
+	void set_object_property(const Symbol& name, const Symbol& property, const Symbol& value, int label);
+	void remove_object(const Symbol& name, int label);
+	void stop_run();
+	bool messages_enabled() const;
+
+	// the handlers run these through run_handler(), which records the call and
+	// dumps the event trace if they throw
+	template <typename... Params, typename... Args>
+	void run_handler(Event_trace::Kind_e kind, long value, void (simple_device::*body)(Params...),
+		Args&&... args);
+	void begin_run();
+	void end_run();
+	void advance_state();
+	void process_keystroke(const Symbol& key_name);
+	void process_eye_start(GU::Point new_location);
+	void process_eye_landing(GU::Point new_location);
+	void trace_event(Event_trace::Kind_e kind, long value = 0, int object = Event_trace::none_c,
+		int detail = Event_trace::none_c);
+	void trace_state_change(State_e previous);
+	int property_label(const Symbol& property) const;
+	void dump_trace_after_error();
+
 	// helpers
 	void parse_condition_string();
+	void start_new_run(unsigned long seed);
+	void seed_rng(unsigned long seed);
+	void name_trial_objects();
+	int random_index(int n);
+	void present_objects(int first, int n = 1);
+	void remove_objects(int first, int n = 1);
     void present_fixation();
     void remove_fixation();
     void present_saccade_target();
+    void hold_fixation();
 	void present_cue();
 	void remove_cue();
 	void start_trial();
 	void present_probe();
 	void remove_probe();
+	void abandon_trial();
+	void update_status_file();
     void remove_saccade_target();
 	void setup_next_trial();
 	void stop_experiment();
 	void make_vis_stim_appear(); //dissappears are handled by response event handlers
 
-	void refresh_experiment(); //tls -> cleans up run vars so that you can re-run after experiment completes
-	
 	void output_statistics(); //const;
+	void output_summary();
+	void output_bootstrap();
+	void output_timing();
+	std::string data_header() const;
+	std::string run_prefix() const;
 	void show_message(const std::string& thestring, const bool addendl = false);
-	void openOutputFile(ofstream & outFileStream, const string filename_text);
+	void openOutputFile(ofstream & outFileStream, const string filename_text, const string& header);
 	bool fexists(const char *filename);
+	bool read_csv_header(const std::string& filename, std::string& header);
 	void stringsplit(std::string str, std::string delim, vector<std::string> results);
 	void clear_prspathvector();
 	std::vector<std::string> &split(const std::string &s, char delim, std::vector<std::string> &elems);